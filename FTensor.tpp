@@ -3,17 +3,33 @@
 /*Front End, Or wrapper*/
 
 #include "Tensor.tpp"
-#include "LazyEval.tpp"
+#include "lazyEval.tpp"
 #include "TensorOps.tpp"
+#include "quant.tpp"
+#include "archive.tpp"
+
+template <typename Q> class QTensor;
+class HalfTensor;
+
 template<typename T>
 class Tensor {
 private:
     Pv<T> storage;
     LazyEval<T, Pv<T>> lazy;
 
+    template <typename> friend class QTensor;
+    friend class HalfTensor;
+    friend class ArchiveWriter;
+
+    // other as an operand, with its pending ops fused in
+    static typename LazyEval<T, Pv<T>>::Operand operand(const Tensor<T>& other) {
+        return LazyEval<T, Pv<T>>::operand(other.storage, other.lazy);
+    }
+
 public:
     Tensor() {}
     Tensor(const std::vector<size_t>& shp, T init=T()) : storage(shp, init) {}
+    Tensor(Pv<T> pv) : storage(std::move(pv)) {}
 
     // Factory
     static Tensor<T> zeros(const std::vector<size_t>& shp) { return Tensor<T>(shp, T(0)); }
@@ -21,24 +37,21 @@ public:
     static Tensor<T> fill(const std::vector<size_t>& shp, T init) { return Tensor<T>(shp, init); }
   //Random________  
     static Tensor<T> random(T min_val, T max_val, const std::vector<size_t>& shape) {
-        Tensor<T> result;
-        result.storage.shape = shape;
-        size_t total = 1;
-        for (auto d : shape) total *= d;
-        result.storage.data.resize(total);
+        Tensor<T> result(shape);
+        T* data = result.storage.mutable_data();
+        size_t total = result.storage.size();
         std::random_device rd;
         std::mt19937 gen(rd());
         if constexpr (std::is_integral<T>::value) {
             std::uniform_int_distribution<T> dist(min_val, max_val);
-            for (auto &v : result.storage.data) v = dist(gen);
+            for (size_t i = 0; i < total; ++i) data[i] = dist(gen);
         } 
         else if constexpr (std::is_floating_point<T>::value) {
             std::uniform_real_distribution<T> dist(min_val, max_val);
-            for (auto &v : result.storage.data) v = dist(gen);}
+            for (size_t i = 0; i < total; ++i) data[i] = dist(gen);}
         else {
             throw std::runtime_error("Unsupported type for random()");
         }
-        result.storage.computeStrides();
         return result;
     }
 
@@ -46,78 +59,126 @@ public:
     // Elementwise operators (lazy)
     // ============================
     Tensor<T>& add(const Tensor<T>& other) {
-    lazy.add(other.storage, [](T x, T y){ return x + y; });
+    lazy.add(OpKind::Add, operand(other));
     return *this;
     }
     Tensor<T>& sub(const Tensor<T>& other) {
-    lazy.add(other.storage, [](T x, T y){ return x - y; });
+    lazy.add(OpKind::Sub, operand(other));
     return *this;
     }
     Tensor<T>& mul(const Tensor<T>& other) {
-    lazy.add(other.storage, [](T x, T y){ return x * y; });
+    lazy.add(OpKind::Mul, operand(other));
     return *this;
     }
     Tensor<T>& div(const Tensor<T>& other) {
-    lazy.add(other.storage, [](T x, T y){ return x / y; });
+    lazy.add(OpKind::Div, operand(other));
     return *this;
     }
-    
-    Tensor<T>& operator+=(const Tensor<T>& other) {
-    lazy.add(other.storage, [](T x, T y){ return x + y; });
+    Tensor<T>& minimum(const Tensor<T>& other) {
+    lazy.add(OpKind::Min, operand(other));
     return *this;
     }
-    Tensor<T>& operator-=(const Tensor<T>& other) {
-    lazy.add(other.storage, [](T x, T y){ return x - y; });
+    Tensor<T>& maximum(const Tensor<T>& other) {
+    lazy.add(OpKind::Max, operand(other));
     return *this;
     }
-    Tensor<T>& operator*=(const Tensor<T>& other) {
-    lazy.add(other.storage, [](T x, T y){ return x * y; });
-    return *this;
-    }
-    Tensor<T>& operator/=(const Tensor<T>& other) {
-    lazy.add(other.storage, [](T x, T y){ return x / y; });
+    // this = this * b + c
+    Tensor<T>& fma(const Tensor<T>& b, const Tensor<T>& c) {
+    lazy.add_fma(operand(b), operand(c));
     return *this;
     }
 
-    Tensor<T> operator+(const Tensor<T>& other) const {
-        Tensor<T> result(*this);
-        result += other;
-        return result;}
-    Tensor<T> operator-(const Tensor<T>& other) const {
-        Tensor<T> result(*this);
-        result -= other;
-        return result;}
-    Tensor<T> operator*(const Tensor<T>& other) const {
-        Tensor<T> result(*this);
-        result *= other;
-        return result;}
-    Tensor<T> operator/(const Tensor<T>& other) const {
-        Tensor<T> result(*this);
-        result /= other;
-        return result;}
+    // Scalar broadcast
+    Tensor<T>& add(T v) { lazy.add(OpKind::Add, v); return *this; }
+    Tensor<T>& sub(T v) { lazy.add(OpKind::Sub, v); return *this; }
+    Tensor<T>& mul(T v) { lazy.add(OpKind::Mul, v); return *this; }
+    Tensor<T>& div(T v) { lazy.add(OpKind::Div, v); return *this; }
+    Tensor<T>& minimum(T v) { lazy.add(OpKind::Min, v); return *this; }
+    Tensor<T>& maximum(T v) { lazy.add(OpKind::Max, v); return *this; }
+    Tensor<T>& fma(T s, T t) { lazy.add_fma(s, t); return *this; }
+    
+    Tensor<T>& operator+=(const Tensor<T>& other) { return add(other); }
+    Tensor<T>& operator-=(const Tensor<T>& other) { return sub(other); }
+    Tensor<T>& operator*=(const Tensor<T>& other) { return mul(other); }
+    Tensor<T>& operator/=(const Tensor<T>& other) { return div(other); }
+    Tensor<T>& operator+=(T v) { return add(v); }
+    Tensor<T>& operator-=(T v) { return sub(v); }
+    Tensor<T>& operator*=(T v) { return mul(v); }
+    Tensor<T>& operator/=(T v) { return div(v); }
+
+    // Binary operators build one fused chain: the left operand's pending
+    // ops carry over, the right operand's pending ops become a sub-chain
+    Tensor<T> operator+(const Tensor<T>& other) const & { Tensor<T> result(*this); result += other; return result; }
+    Tensor<T> operator-(const Tensor<T>& other) const & { Tensor<T> result(*this); result -= other; return result; }
+    Tensor<T> operator*(const Tensor<T>& other) const & { Tensor<T> result(*this); result *= other; return result; }
+    Tensor<T> operator/(const Tensor<T>& other) const & { Tensor<T> result(*this); result /= other; return result; }
+    Tensor<T> operator+(const Tensor<T>& other) && { *this += other; return std::move(*this); }
+    Tensor<T> operator-(const Tensor<T>& other) && { *this -= other; return std::move(*this); }
+    Tensor<T> operator*(const Tensor<T>& other) && { *this *= other; return std::move(*this); }
+    Tensor<T> operator/(const Tensor<T>& other) && { *this /= other; return std::move(*this); }
+    Tensor<T> operator+(T v) const & { Tensor<T> result(*this); result += v; return result; }
+    Tensor<T> operator-(T v) const & { Tensor<T> result(*this); result -= v; return result; }
+    Tensor<T> operator*(T v) const & { Tensor<T> result(*this); result *= v; return result; }
+    Tensor<T> operator/(T v) const & { Tensor<T> result(*this); result /= v; return result; }
+    Tensor<T> operator+(T v) && { *this += v; return std::move(*this); }
+    Tensor<T> operator-(T v) && { *this -= v; return std::move(*this); }
+    Tensor<T> operator*(T v) && { *this *= v; return std::move(*this); }
+    Tensor<T> operator/(T v) && { *this /= v; return std::move(*this); }
 
     // ============================
     // Unary ops (lazy)
     // ============================
     Tensor<T>& sqrt() {
-    lazy.add(storage, [](T x, T){ return std::sqrt(x); });
+    lazy.add_unary(UnaryKind::Sqrt);
     return *this;
 }
 
 Tensor<T>& pow(T v) {
-    lazy.add(storage, [v](T x, T){ return std::pow(x, v); });
+    lazy.add_unary(UnaryKind::Pow, v);
     return *this;
 }
 
 Tensor<T>& sin() {
-    lazy.add(storage, [](T x, T){ return std::sin(x); });
+    lazy.add_unary(UnaryKind::Sin);
     return *this;
 }
 
 Tensor<T>& cos() {
-    lazy.add(storage, [](T x, T){ return std::cos(x); });
+    lazy.add_unary(UnaryKind::Cos);
     return *this;
 }
+
+Tensor<T>& exp() {
+    lazy.add_unary(UnaryKind::Exp);
+    return *this;
+}
+
+Tensor<T>& log() {
+    lazy.add_unary(UnaryKind::Log);
+    return *this;
+}
+
+Tensor<T>& tanh() {
+    lazy.add_unary(UnaryKind::Tanh);
+    return *this;
+}
+
+Tensor<T>& sigmoid() {
+    lazy.add_unary(UnaryKind::Sigmoid);
+    return *this;
+}
+
+Tensor<T>& gelu() {
+    lazy.add_unary(UnaryKind::Gelu);
+    return *this;
+}
+
+    // Custom element-wise op f(this, other), scalar path
+    template <typename Func>
+    Tensor<T>& apply(const Tensor<T>& other, Func f) {
+        lazy.add(operand(other), f);
+        return *this;
+    }
     //============================
     //Statistic operator
     //============================
@@ -129,7 +190,52 @@ Tensor<T>& cos() {
     std::vector<size_t> shape() const {return Ops<T>::shape(storage);}
     size_t argmax() const { return Ops<T>::argmax(storage); }
     size_t argmin() const { return Ops<T>::argmin(storage);}
+    T var() const { return Ops<T>::var(storage); }
+    T stddev() const { return Ops<T>::stddev(storage); }
+    // e.g. stats({StatKind::Mean, StatKind::Max, StatKind::ArgMax}), one pass
+    std::vector<T> stats(const std::vector<StatKind>& kinds) const { return Ops<T>::stats(storage, kinds); }
     T dot(const Tensor<T>& other) const { return Ops<T>::dot(storage, other.storage); }
+
+    // Reductions along axes
+    Tensor<T> sum(const std::vector<size_t>& axes, bool keepdims = false) const { return Ops<T>::sum(storage, axes, keepdims); }
+    Tensor<T> mean(const std::vector<size_t>& axes, bool keepdims = false) const { return Ops<T>::mean(storage, axes, keepdims); }
+    Tensor<T> max(const std::vector<size_t>& axes, bool keepdims = false) const { return Ops<T>::max(storage, axes, keepdims); }
+    Tensor<T> min(const std::vector<size_t>& axes, bool keepdims = false) const { return Ops<T>::min(storage, axes, keepdims); }
+    Tensor<T> var(const std::vector<size_t>& axes, size_t ddof = 0, bool keepdims = false) const { return Ops<T>::var(storage, axes, ddof, keepdims); }
+    Tensor<T> stddev(const std::vector<size_t>& axes, size_t ddof = 0, bool keepdims = false) const { return Ops<T>::stddev(storage, axes, ddof, keepdims); }
+    Tensor<size_t> argmax(size_t axis, bool keepdims = false) const { return Ops<T>::argmax(storage, axis, keepdims); }
+    Tensor<size_t> argmin(size_t axis, bool keepdims = false) const { return Ops<T>::argmin(storage, axis, keepdims); }
+    //========================
+    //=====Linear algebra======
+    //========================
+    Tensor<T> matmul(const Tensor<T>& other) const { return Ops<T>::matmul(storage, other.storage); }
+    Tensor<T> bmm(const Tensor<T>& other) const { return Ops<T>::bmm(storage, other.storage); }
+    // act(this W^T + b): this [..., in], W [out, in], b [out] or empty
+    Tensor<T> linear(const Tensor<T>& W, const Tensor<T>& b = Tensor<T>(),
+                     Activation act = Activation::None) const {
+        return Ops<T>::linear(storage, W.storage, b.storage, act);
+    }
+    // Quantized or fp16 weights, float input: int8 weights quantize the
+    // input on the fly and accumulate in int32, fp16 weights compute in fp32
+    template <typename Q>
+    Tensor<T> linear(const QTensor<Q>& W, const Tensor<T>& b = Tensor<T>(),
+                     Activation act = Activation::None) const;
+    Tensor<T> linear(const HalfTensor& W, const Tensor<T>& b = Tensor<T>(),
+                     Activation act = Activation::None) const;
+    //========================
+    //=====Normalization=======
+    //========================
+    // Fused along one axis: one statistics sweep and one normalize sweep per row
+    Tensor<T> softmax(size_t axis) const { return Ops<T>::softmax(storage, axis); }
+    Tensor<T> log_softmax(size_t axis) const { return Ops<T>::log_softmax(storage, axis); }
+    // gamma, beta: [shape[axis]] or empty
+    Tensor<T> layernorm(size_t axis, T eps = T(1e-5), const Tensor<T>& gamma = Tensor<T>(),
+                        const Tensor<T>& beta = Tensor<T>()) const {
+        return Ops<T>::layernorm(storage, axis, eps, gamma.storage, beta.storage);
+    }
+    Tensor<T> rmsnorm(size_t axis, T eps = T(1e-6), const Tensor<T>& gamma = Tensor<T>()) const {
+        return Ops<T>::rmsnorm(storage, axis, eps, gamma.storage);
+    }
     //========================
     //=====Tensor Manipulation===
     //===================≠====
@@ -138,6 +244,24 @@ Tensor<T>& cos() {
     return *this;}
     Tensor<T> reshaped(const std::vector<size_t>& nw)     const {
         return Ops<T>::reshape(storage, nw);}
+    // Views: O(1), share storage, copy-on-write when mutated
+    Tensor<T> slice(size_t axis, size_t begin, size_t end, size_t step = 1) const {
+        return Ops<T>::slice(storage, axis, begin, end, step);}
+    Tensor<T> transpose() const { return Ops<T>::transpose(storage); }
+    Tensor<T> transpose(const std::vector<size_t>& perm) const { return Ops<T>::transpose(storage, perm); }
+    Tensor<T> expand(const std::vector<size_t>& shp) const { return Ops<T>::expand(storage, shp); }
+    Tensor<T> contiguous() const { return Tensor<T>(storage.contiguous()); }
+    bool is_contiguous() const { return storage.is_contiguous(); }
+    // False for tensors mapped from an archive until they are written to
+    bool is_writable() const { return storage.buf && storage.buf->writable; }
+
+    T at(const std::vector<size_t>& coord) const {
+        if (coord.size() != storage.shape.size()) throw std::runtime_error("at: rank mismatch");
+        for (size_t d = 0; d < coord.size(); ++d)
+            if (coord[d] >= storage.shape[d]) throw std::runtime_error("at: index out of range");
+        return storage.buf->ptr[storage.flattenIndex(coord)];
+    }
+    std::vector<T> to_vector() const { return storage.to_vector(); }
 
 Tensor<T>& assign(T value) {
     Ops<T>::assign(storage, value);
@@ -166,16 +290,158 @@ Tensor<T> assign(const std::vector<size_t>& start,
         return *this;
     }
 
+    // Process-wide op profiler, e.g. Tensor<float>::profiler().enable()
+    static Profiler& profiler() { return Profiler::global(); }
+
+    // ============================
+    // Persistence
+    // ============================
+    // Single-tensor archive of the stored values; pending ops are not
+    // applied, call evaluate() first
+    void save(const std::string& path, const std::string& name = "tensor") const {
+        ArchiveWriter w(path);
+        w.add(name, *this);
+        w.finish();
+    }
+    // Zero-copy: the result maps the file read-only, pages load on first use
+    static Tensor<T> load(const std::string& path, const std::string& name = "tensor") {
+        return TensorArchive(path).get<T>(name);
+    }
+
     void print() const {
-        for (size_t i = 0; i < storage.data.size(); ++i) {
-            std::cout << storage.data[i];
-            if (i + 1 != storage.data.size()) std::cout << ", ";
+        std::vector<T> values = storage.to_vector();
+        for (size_t i = 0; i < values.size(); ++i) {
+            std::cout << values[i];
+            if (i + 1 != values.size()) std::cout << ", ";
         }
         std::cout << "\n";
     }
     
 };
 
+// =====================
+// QTensor: int8_t / uint8_t codes with scale and zero-point
+// =====================
+template <typename Q>
+class QTensor {
+private:
+    Pv<Q> storage;
+    QParams params;
+
+    template <typename> friend class Tensor;
+    template <typename> friend class QTensor;
+    friend class ArchiveWriter;
+
+public:
+    QTensor() {}
+    QTensor(Pv<Q> q, QParams p) : storage(std::move(q)), params(std::move(p)) {
+        Quant<Q>::check(storage.shape, params);
+    }
+
+    // Parameters from the range of x; axis >= 0 gives one pair per channel
+    static QTensor<Q> quantize(const Tensor<float>& x, bool symmetric = true, long axis = -1) {
+        QParams p = Quant<Q>::choose(x.storage, symmetric, axis);
+        return QTensor<Q>(Quant<Q>::quantize(x.storage, p), p);
+    }
+    static QTensor<Q> quantize(const Tensor<float>& x, const QParams& p) {
+        return QTensor<Q>(Quant<Q>::quantize(x.storage, p), p);
+    }
+    Tensor<float> dequantize() const { return Quant<Q>::dequantize(storage, params); }
+
+    const QParams& qparams() const { return params; }
+    std::vector<size_t> shape() const { return storage.shape; }
+    size_t size() const { return storage.size(); }
+    std::vector<Q> to_vector() const { return storage.to_vector(); }
+
+    // Element-wise, requantized to out (default: this tensor's parameters)
+    QTensor<Q> add(const QTensor<Q>& o) const { return add(o, params); }
+    QTensor<Q> sub(const QTensor<Q>& o) const { return sub(o, params); }
+    QTensor<Q> mul(const QTensor<Q>& o) const { return mul(o, params); }
+    QTensor<Q> add(const QTensor<Q>& o, const QParams& out) const { return binary(OpKind::Add, o, out); }
+    QTensor<Q> sub(const QTensor<Q>& o, const QParams& out) const { return binary(OpKind::Sub, o, out); }
+    QTensor<Q> mul(const QTensor<Q>& o, const QParams& out) const { return binary(OpKind::Mul, o, out); }
+    QTensor<Q> minimum(const QTensor<Q>& o, const QParams& out) const { return binary(OpKind::Min, o, out); }
+    QTensor<Q> maximum(const QTensor<Q>& o, const QParams& out) const { return binary(OpKind::Max, o, out); }
+
+    // int32 accumulation, float result
+    template <typename R>
+    float dot(const QTensor<R>& o) const { return Quant<Q>::dot(storage, params, o.storage, o.params); }
+    // [..., K] x [K, N]; this per-tensor, o per-tensor or per-column
+    template <typename R>
+    Tensor<float> matmul(const QTensor<R>& o) const {
+        return Quant<Q>::matmul(storage, params, o.storage, o.params);
+    }
+
+private:
+    QTensor<Q> binary(OpKind op, const QTensor<Q>& o, const QParams& out) const {
+        return QTensor<Q>(Quant<Q>::binary(op, storage, params, o.storage, o.params, out), out);
+    }
+};
+
+// =====================
+// HalfTensor: fp16 storage, fp32 compute
+// =====================
+class HalfTensor {
+private:
+    Pv<Half> storage;
+
+    template <typename> friend class Tensor;
+    friend class TensorArchive;
+    friend class ArchiveWriter;
+
+public:
+    HalfTensor() {}
+    explicit HalfTensor(const Tensor<float>& x) : storage(HalfOps::to_half(x.storage)) {}
+
+    Tensor<float> to_float() const { return HalfOps::to_float(storage); }
+    std::vector<size_t> shape() const { return storage.shape; }
+    size_t size() const { return storage.size(); }
+};
+
+template <typename T>
+template <typename Q>
+Tensor<T> Tensor<T>::linear(const QTensor<Q>& W, const Tensor<T>& b, Activation act) const {
+    static_assert(std::is_same<T, float>::value, "quantized linear takes a float input");
+    return Quant<Q>::linear(storage, W.storage, W.params, b.storage, act);
+}
+
+template <typename T>
+Tensor<T> Tensor<T>::linear(const HalfTensor& W, const Tensor<T>& b, Activation act) const {
+    static_assert(std::is_same<T, float>::value, "fp16 linear takes a float input");
+    return HalfOps::linear(storage, W.storage, b.storage, act);
+}
+
+// =====================
+// Archive front end
+// =====================
+template <typename T>
+Tensor<T> TensorArchive::get(const std::string& name) const {
+    const ArchiveEntry& e = entry(name);
+    if (e.quantized) throw std::runtime_error("archive: '" + name + "' is quantized, use get_quantized");
+    return Tensor<T>(view<T>(name));
+}
+
+template <typename Q>
+QTensor<Q> TensorArchive::get_quantized(const std::string& name) const {
+    const ArchiveEntry& e = entry(name);
+    if (!e.quantized) throw std::runtime_error("archive: '" + name + "' is not quantized");
+    return QTensor<Q>(view<Q>(name), e.q);
+}
+
+inline HalfTensor TensorArchive::get_half(const std::string& name) const {
+    HalfTensor h;
+    h.storage = view<Half>(name);
+    return h;
+}
+
+template <typename T>
+void ArchiveWriter::add(const std::string& name, const Tensor<T>& x) { write(name, x.storage); }
+
+template <typename Q>
+void ArchiveWriter::add(const std::string& name, const QTensor<Q>& x) { write(name, x.storage, &x.params); }
+
+inline void ArchiveWriter::add(const std::string& name, const HalfTensor& x) { write(name, x.storage); }
+
 template<typename T>
 void print(const std::vector<T>& vec, const std::string& label = "") {
     if (!label.empty()) std::cout << label << ": ";
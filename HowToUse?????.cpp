@@ -1,4 +1,4 @@
-#include "Ftensor.hpp"
+#include "FTensor.tpp"
 #include <iostream>
 /* How to use The Tensor core. 
 if not work -> ¯\_(ツ)_/¯  */
@@ -2,48 +2,221 @@
 
 #include <vector>
 #include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <algorithm>
 
 /* Tensor Core tpp*/
 
+// Reference-counted storage. Owns its elements, or points into memory kept
+// alive by keepalive (read-only when writable is false)
+template<typename T>
+struct Buffer {
+    std::vector<T> owned;
+    T* ptr = nullptr;
+    size_t len = 0;
+    std::shared_ptr<const void> keepalive;
+    bool writable = true;
+
+    explicit Buffer(size_t n, T init = T()) : owned(n, init), ptr(owned.data()), len(n) {}
+    explicit Buffer(std::vector<T> values) : owned(std::move(values)), ptr(owned.data()), len(owned.size()) {}
+    Buffer(T* p, size_t n, std::shared_ptr<const void> hold, bool w)
+        : ptr(p), len(n), keepalive(std::move(hold)), writable(w) {}
+};
+
+// Visit (shape, strides) from base in row-major order as runs along the
+// last axis: fn(offset, count, stride). No per-element div/mod.
+template <typename Fn>
+void for_each_run(const std::vector<size_t>& shape, const std::vector<size_t>& strides, size_t base, Fn&& fn) {
+    size_t nd = shape.size();
+    if (nd == 0) { fn(base, size_t(1), size_t(1)); return; }
+    for (auto e : shape) if (e == 0) return;
+
+    std::vector<size_t> coord(nd, 0);
+    size_t off = base;
+    while (true) {
+        fn(off, shape[nd - 1], strides[nd - 1]);
+        size_t d = nd - 1;
+        while (true) {
+            if (d == 0) return;
+            --d;
+            off += strides[d];
+            if (++coord[d] < shape[d]) break;
+            off -= strides[d] * shape[d];
+            coord[d] = 0;
+        }
+    }
+}
+
 template<typename T>
 struct Pv {
-    //Data 
-    std::vector<T> data; //flat data
+    //Data
+    std::shared_ptr<Buffer<T>> buf; //shared flat data
+    size_t offset = 0; //first element in buf
     std::vector<size_t> shape; //shape data
-    std::vector<size_t> strides; //Strides data
-    //constructor 
+    std::vector<size_t> strides; //Strides data, in elements, 0 = broadcast
+    //constructor
     Pv() {}
-    //constructor 
+    //constructor
     Pv(const std::vector<size_t>& shp, T init = T()) : shape(shp) {
         computeStrides();
-        data.resize(size(), init);
+        buf = std::make_shared<Buffer<T>>(count(), init);
     }
-    //Constructor 
-    Pv(const std::vector<T>& values) : shape({values.size()}), data(values) {
+    //Constructor
+    Pv(const std::vector<T>& values) : buf(std::make_shared<Buffer<T>>(values)), shape({values.size()}) {
         computeStrides();
     }
-    //Strides compute for Cordinate
+    //Strides compute for Cordinate (row-major)
     void computeStrides() {
-        strides.resize(shape.size(), 1);
+        strides.assign(shape.size(), 1);
         for (int i = int(shape.size()) - 2; i >= 0; i--)
             strides[i] = strides[i + 1] * shape[i + 1];
     }
-    
-    //Get a flat cordinate
+
+    //Get a flat cordinate into buf
     size_t flattenIndex(const std::vector<size_t>& coord) const {
-        size_t idx = 0;
+        size_t idx = offset;
         for (size_t i = 0; i < coord.size(); i++)
             idx += (shape[i] == 1 ? 0 : coord[i]) * strides[i];
         return idx;
     }
 
-    T& operator[](size_t idx) { return data[idx]; }
-    const T& operator[](size_t idx) const { return data[idx]; }
+    // Position in buf of the idx-th element in row-major order
+    size_t locate(size_t idx) const {
+        size_t off = offset;
+        for (size_t d = shape.size(); d-- > 0;) {
+            off += (idx % shape[d]) * strides[d];
+            idx /= shape[d];
+        }
+        return off;
+    }
+
+    T& operator[](size_t idx) { return mutable_data()[idx]; }
+    const T& operator[](size_t idx) const { return buf->ptr[locate(idx)]; }
 
     //Return size
-    size_t size() const {
+    size_t size() const { return buf ? count() : 0; }
+
+    size_t count() const {
         size_t tot = 1;
         for (auto s : shape) tot *= s;
         return tot;
     }
+
+    // ------------------------------
+    // Layout
+    // ------------------------------
+    bool is_contiguous() const {
+        size_t expected = 1;
+        for (size_t d = shape.size(); d-- > 0;) {
+            if (shape[d] == 1) continue;
+            if (strides[d] != expected) return false;
+            expected *= shape[d];
+        }
+        return true;
+    }
+
+    // Sole, writable owner of buf
+    bool unique() const { return buf && buf.use_count() == 1 && buf->writable; }
+
+    // First element; row-major flat data only when is_contiguous()
+    const T* data() const { return buf ? buf->ptr + offset : nullptr; }
+
+    // Copy-on-write: detach from shared, read-only or strided storage
+    T* mutable_data() {
+        if (!buf) return nullptr;
+        if (!unique() || !is_contiguous()) *this = copy();
+        return buf->ptr + offset;
+    }
+
+    // Fresh contiguous copy
+    Pv copy() const {
+        Pv r;
+        r.shape = shape;
+        r.computeStrides();
+        r.buf = std::make_shared<Buffer<T>>(count());
+        copy_to(r.buf->ptr);
+        return r;
+    }
+
+    // Shares storage when already contiguous
+    Pv contiguous() const { return is_contiguous() ? *this : copy(); }
+
+    void copy_to(T* out) const {
+        if (!buf) return;
+        const T* src = buf->ptr;
+        for_each_run(shape, strides, offset, [&](size_t off, size_t n, size_t st) {
+            if (st == 1) out = std::copy(src + off, src + off + n, out);
+            else for (size_t i = 0; i < n; ++i) *out++ = src[off + i * st];
+        });
+    }
+
+    std::vector<T> to_vector() const {
+        std::vector<T> v(size());
+        copy_to(v.data());
+        return v;
+    }
+
+    // ------------------------------
+    // O(1) views, sharing buf
+    // ------------------------------
+    Pv reshape(const std::vector<size_t>& nw) const {
+        size_t tot = 1;
+        for (auto d : nw) tot *= d;
+        if (tot != count())
+            throw std::runtime_error("Reshape failed: element count mismatch");
+        if (!is_contiguous()) return copy().reshape(nw);
+        Pv r = *this;
+        r.shape = nw;
+        r.computeStrides();
+        return r;
+    }
+
+    // Elements begin, begin + step, ... < end along axis
+    Pv slice(size_t axis, size_t begin, size_t end, size_t step = 1) const {
+        if (axis >= shape.size()) throw std::runtime_error("slice: axis out of range");
+        end = std::min(end, shape[axis]);
+        if (begin > end || step == 0) throw std::runtime_error("slice: bad range");
+        Pv r = *this;
+        r.offset += begin * strides[axis];
+        r.shape[axis] = (end - begin + step - 1) / step;
+        r.strides[axis] *= step;
+        return r;
+    }
+
+    // Axis d of the result is axis perm[d] of this
+    Pv transpose(const std::vector<size_t>& perm) const {
+        if (perm.size() != shape.size()) throw std::runtime_error("transpose: bad permutation");
+        Pv r = *this;
+        std::vector<bool> seen(perm.size(), false);
+        for (size_t d = 0; d < perm.size(); ++d) {
+            if (perm[d] >= shape.size() || seen[perm[d]])
+                throw std::runtime_error("transpose: bad permutation");
+            seen[perm[d]] = true;
+            r.shape[d] = shape[perm[d]];
+            r.strides[d] = strides[perm[d]];
+        }
+        return r;
+    }
+
+    // Reverse all axes
+    Pv transpose() const {
+        std::vector<size_t> perm(shape.size());
+        for (size_t d = 0; d < perm.size(); ++d) perm[d] = perm.size() - 1 - d;
+        return transpose(perm);
+    }
+
+    // Broadcast to target with stride 0 on expanded axes
+    Pv expand(const std::vector<size_t>& target) const {
+        if (target.size() < shape.size()) throw std::runtime_error("expand: too few dims");
+        size_t shift = target.size() - shape.size();
+        Pv r = *this;
+        r.shape = target;
+        r.strides.assign(target.size(), 0);
+        for (size_t d = 0; d < shape.size(); ++d) {
+            if (shape[d] == target[d + shift]) r.strides[d + shift] = strides[d];
+            else if (shape[d] != 1) throw std::runtime_error("expand: incompatible shapes");
+        }
+        return r;
+    }
 };
@@ -1,5 +1,7 @@
 #pragma once
-#include "LazyStat.tpp"
+#include "lazyStat.tpp"
+#include "gemm.tpp"
+#include "normalize.tpp"
 #include "pch.tpp"
 #include "Tensor.tpp"
 
@@ -7,20 +9,29 @@ template<typename T>
 struct Ops {
     using PvT = Pv<T>;
 
+    using Stat = LazyEvalStat<T, PvT>;
+    using Acc = StatAcc<T>;
+
+    // One fused pass for every kind in kinds
+    static Acc summarize(const PvT& a, std::initializer_list<StatKind> kinds) {
+        Stat lazy;
+        for (auto k : kinds) lazy.add(k);
+        return lazy.summarize(a);
+    }
+
+    static const PvT& nonempty(const PvT& a, const char* what) {
+        if (a.size() == 0) throw std::runtime_error(std::string(what) + " of empty tensor");
+        return a;
+    }
+
     // SUM
     static T sum(const PvT& a) {
-        LazyEvalStat<T, PvT> lazy;
-        lazy.add_sum();
-        return lazy.execute(a)[0];
+        return summarize(a, { StatKind::Sum }).sum;
     }
 
     // LEN
     static T len(const PvT& a) {
-        LazyEvalStat<T, PvT> lazy;
-        lazy.add([](const PvT& core) {
-            return static_cast<T>(core.data.size());
-        });
-        return lazy.execute(a)[0];
+        return static_cast<T>(a.size());
     }
     
     static std::vector<size_t> shape(const PvT& a) {
@@ -29,109 +40,273 @@ struct Ops {
 
     // MAX
     static T max(const PvT& a) {
-        LazyEvalStat<T, PvT> lazy;
-        lazy.add([](const PvT& core) {
-            return *std::max_element(core.data.begin(), core.data.end());
-        });
-        return lazy.execute(a)[0];
+        return summarize(nonempty(a, "max"), { StatKind::Max }).max;
     }
 
     // MIN
     static T min(const PvT& a) {
-        LazyEvalStat<T, PvT> lazy;
-        lazy.add([](const PvT& core) {
-            return *std::min_element(core.data.begin(), core.data.end());
-        });
-        return lazy.execute(a)[0];
+        return summarize(nonempty(a, "min"), { StatKind::Min }).min;
     }
 
     // MEAN
     static T mean(const PvT& a) {
-        LazyEvalStat<T, PvT> lazy;
-        lazy.add([](const PvT& core) {
-            T s = 0;
-            for (auto v : core.data) s += v;
-            return s / static_cast<T>(core.data.size());
-        });
-        return lazy.execute(a)[0];
+        return Stat::mean_of(summarize(a, { StatKind::Mean }));
+    }
+
+    // VAR / STD, ddof = 1 for the sample estimate
+    static T var(const PvT& a, size_t ddof = 0) {
+        return static_cast<T>(summarize(a, { StatKind::Var }).var(ddof));
+    }
+
+    static T stddev(const PvT& a, size_t ddof = 0) {
+        return static_cast<T>(std::sqrt(summarize(a, { StatKind::Std }).var(ddof)));
     }
 
-    // ARGMAX (lazy)
+    // ARGMAX
 static size_t argmax(const PvT& a) {
-    LazyEvalStat<size_t, PvT> lazy;
-    lazy.add([](const PvT& core) -> size_t {
-        return std::distance(core.data.begin(),
-                             std::max_element(core.data.begin(), core.data.end()));
-    });
-    return lazy.execute(a)[0];
+    return summarize(nonempty(a, "argmax"), { StatKind::ArgMax }).argmax;
 }
 
-// ARGMIN (lazy)
+// ARGMIN
 static size_t argmin(const PvT& a) {
-    LazyEvalStat<size_t, PvT> lazy;
-    lazy.add([](const PvT& core) -> size_t {
-        return std::distance(core.data.begin(),
-                             std::min_element(core.data.begin(), core.data.end()));
-    });
-    return lazy.execute(a)[0];
+    return summarize(nonempty(a, "argmin"), { StatKind::ArgMin }).argmin;
 }
 
-    static PvT reshape(const PvT& a, const std::vector<size_t>& nw_shp) {
-    size_t nw_tlt = 1;
-    for (auto d : nw_shp) nw_tlt *= d;
+    // Several statistics from one pass, values in the order asked
+    static std::vector<T> stats(const PvT& a, const std::vector<StatKind>& kinds) {
+        Stat lazy;
+        for (auto k : kinds) lazy.add(k);
+        return lazy.execute(a);
+    }
 
-    size_t old_tlt = 1;
-    for (auto d : a.shape) old_tlt *= d;
-    
-    if (nw_tlt != old_tlt)
-        throw std::runtime_error("Reshape failed: element count mismatch");
+    // ============================
+    // Axis reductions
+    // ============================
+    static std::vector<size_t> reduced_shape(const PvT& a, const std::vector<size_t>& axes, bool keepdims) {
+        std::vector<size_t> shp;
+        for (size_t d = 0; d < a.shape.size(); ++d) {
+            bool r = std::find(axes.begin(), axes.end(), d) != axes.end();
+            if (!r) shp.push_back(a.shape[d]);
+            else if (keepdims) shp.push_back(1);
+        }
+        return shp;
+    }
 
-    PvT result;
-    result.data = a.data;
-    result.shape = nw_shp;  // ← fix
-    result.computeStrides();
-    return result;
+    template <typename R, typename Fn>
+    static Pv<R> reduce(const PvT& a, const std::vector<size_t>& axes, bool keepdims,
+                        typename Stat::Needs need, Fn fn) {
+        std::vector<Acc> accs = Stat::reduce_axes(a, axes, need);
+        Pv<R> result;   // not Pv(shape): ambiguous with Pv(values) for R = size_t
+        result.shape = reduced_shape(a, axes, keepdims);
+        result.computeStrides();
+        result.buf = std::make_shared<Buffer<R>>(accs.size());
+        for (size_t i = 0; i < accs.size(); ++i) result.buf->ptr[i] = fn(accs[i]);
+        return result;
+    }
+
+    static PvT sum(const PvT& a, const std::vector<size_t>& axes, bool keepdims = false) {
+        return reduce<T>(a, axes, keepdims, {}, [](const Acc& s) { return s.sum; });
+    }
+
+    static PvT mean(const PvT& a, const std::vector<size_t>& axes, bool keepdims = false) {
+        return reduce<T>(a, axes, keepdims, {}, [](const Acc& s) { return Stat::mean_of(s); });
+    }
+
+    static PvT max(const PvT& a, const std::vector<size_t>& axes, bool keepdims = false) {
+        return reduce<T>(nonempty(a, "max"), axes, keepdims, {}, [](const Acc& s) { return s.max; });
+    }
+
+    static PvT min(const PvT& a, const std::vector<size_t>& axes, bool keepdims = false) {
+        return reduce<T>(nonempty(a, "min"), axes, keepdims, {}, [](const Acc& s) { return s.min; });
+    }
+
+    static PvT var(const PvT& a, const std::vector<size_t>& axes, size_t ddof = 0, bool keepdims = false) {
+        return reduce<T>(a, axes, keepdims, { false, true },
+                         [ddof](const Acc& s) { return static_cast<T>(s.var(ddof)); });
+    }
+
+    static PvT stddev(const PvT& a, const std::vector<size_t>& axes, size_t ddof = 0, bool keepdims = false) {
+        return reduce<T>(a, axes, keepdims, { false, true },
+                         [ddof](const Acc& s) { return static_cast<T>(std::sqrt(s.var(ddof))); });
+    }
+
+    static Pv<size_t> argmax(const PvT& a, size_t axis, bool keepdims = false) {
+        return reduce<size_t>(nonempty(a, "argmax"), { axis }, keepdims, { true, false },
+                              [](const Acc& s) { return s.argmax; });
+    }
+
+    static Pv<size_t> argmin(const PvT& a, size_t axis, bool keepdims = false) {
+        return reduce<size_t>(nonempty(a, "argmin"), { axis }, keepdims, { true, false },
+                              [](const Acc& s) { return s.argmin; });
+    }
+
+    // ============================
+    // Linear algebra
+    // ============================
+    // Flat inner product, a and b hold the same number of elements
+    static T dot(const PvT& a, const PvT& b) {
+        if (a.size() != b.size()) throw std::runtime_error("dot: size mismatch");
+        PvT ca = a.contiguous(), cb = b.contiguous();
+        return Gemm<T>::dot(ca.data(), cb.data(), ca.size());
+    }
+
+    // numpy rules: [..., M, K] x [..., K, N] -> [..., M, N], leading dims
+    // broadcast; a 1-D operand is a row (left) or column (right) vector
+    static PvT matmul(const PvT& a, const PvT& b) {
+        return product(a, b, Epilogue<T>());
+    }
+
+    // Batched product, both operands rank >= 3
+    static PvT bmm(const PvT& a, const PvT& b) {
+        if (a.shape.size() < 3 || b.shape.size() < 3)
+            throw std::runtime_error("bmm: operands must have rank >= 3");
+        return product(a, b, Epilogue<T>());
+    }
+
+    // act(x W^T + bias): x [..., in], W [out, in], bias [out] or empty.
+    // Bias and activation are applied while each output block is in cache
+    static PvT linear(const PvT& x, const PvT& W, const PvT& bias, Activation act = Activation::None) {
+        if (W.shape.size() != 2) throw std::runtime_error("linear: weight must be [out, in]");
+        if (x.shape.empty() || x.shape.back() != W.shape[1])
+            throw std::runtime_error("linear: input features do not match weight");
+        Epilogue<T> ep;
+        ep.act = act;
+        if (bias.size() != 0) {
+            if (bias.shape.size() != 1 || bias.shape[0] != W.shape[0])
+                throw std::runtime_error("linear: bias must be [out]");
+            ep.bias = bias.data();
+            ep.bias_stride = bias.strides[0];
+        }
+        return product(x, W.transpose(), ep);
+    }
+
+    static PvT product(const PvT& a, const PvT& b, const Epilogue<T>& ep) {
+        if (a.shape.empty() || b.shape.empty()) throw std::runtime_error("matmul: scalar operand");
+        PvT x = a, y = b;
+        bool row = x.shape.size() == 1, col = y.shape.size() == 1;
+        if (row) { x.shape.insert(x.shape.begin(), 1); x.strides.insert(x.strides.begin(), 0); }
+        if (col) { y.shape.push_back(1); y.strides.push_back(0); }
+
+        size_t rx = x.shape.size(), ry = y.shape.size();
+        size_t M = x.shape[rx - 2], K = x.shape[rx - 1], N = y.shape[ry - 1];
+        if (y.shape[ry - 2] != K) throw std::runtime_error("matmul: inner dimensions differ");
+
+        // Broadcast the leading dims as stride-0 views
+        size_t nb = std::max(rx, ry) - 2;
+        std::vector<size_t> batch(nb, 1);
+        for (size_t d = 0; d < nb; ++d) {
+            size_t ex = d + rx - 2 >= nb ? x.shape[d + rx - 2 - nb] : 1;
+            size_t ey = d + ry - 2 >= nb ? y.shape[d + ry - 2 - nb] : 1;
+            if (ex != ey && ex != 1 && ey != 1) throw std::runtime_error("matmul: batch dims do not broadcast");
+            batch[d] = std::max(ex, ey);
+        }
+        std::vector<size_t> shp = batch;
+        shp.push_back(M); shp.push_back(K);
+        x = x.expand(shp);
+        shp[nb] = K; shp[nb + 1] = N;
+        y = y.expand(shp);
+        shp[nb] = M;
+
+        PvT out;
+        out.shape = shp;
+        out.computeStrides();
+        out.buf = std::make_shared<Buffer<T>>(out.count());
+
+        // Offsets of each matrix: the batch dims alone, as views
+        PvT bx = x, by = y;
+        bx.shape.resize(nb); bx.strides.resize(nb);
+        by.shape.resize(nb); by.strides.resize(nb);
+
+        size_t B = out.count() / std::max<size_t>(1, M * N);
+        if (M * N == 0) B = 0;
+        T* dst = out.buf->ptr;
+        Executor::global().parallel_for(0, B, 1, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i)
+                Gemm<T>::run(M, N, K,
+                             { x.buf->ptr + bx.locate(i), x.strides[nb], x.strides[nb + 1] },
+                             { y.buf->ptr + by.locate(i), y.strides[nb], y.strides[nb + 1] },
+                             dst + i * M * N, N, ep);
+        }, std::max<size_t>(1, M * N * K / 64));
+
+        if (row) out.shape.erase(out.shape.end() - 2);
+        if (col) out.shape.pop_back();
+        out.computeStrides();
+        return out;
+    }
+
+    // ============================
+    // Normalization along one axis
+    // ============================
+    static PvT softmax(const PvT& a, size_t axis) {
+        return Normalize<T>::run(a, axis, NormKind::Softmax);
+    }
+
+    static PvT log_softmax(const PvT& a, size_t axis) {
+        return Normalize<T>::run(a, axis, NormKind::LogSoftmax);
+    }
+
+    // gamma, beta: [a.shape[axis]] or empty
+    static PvT layernorm(const PvT& a, size_t axis, T eps, const PvT& gamma, const PvT& beta) {
+        return Normalize<T>::run(a, axis, NormKind::LayerNorm, eps, gamma, beta);
+    }
+
+    static PvT rmsnorm(const PvT& a, size_t axis, T eps, const PvT& gamma) {
+        return Normalize<T>::run(a, axis, NormKind::RmsNorm, eps, gamma);
+    }
+
+    // O(1) view when a is contiguous
+    static PvT reshape(const PvT& a, const std::vector<size_t>& nw_shp) {
+    return a.reshape(nw_shp);
 }
 
 static void reshape(PvT& a, const std::vector<size_t>& nw_shp) {
-    size_t nw_tlt = 1;
-    for (auto d : nw_shp) nw_tlt *= d;
-
-    size_t old_tlt = 1;
-    for (auto d : a.shape) old_tlt *= d;
-    
-    if (nw_tlt != old_tlt)
-        throw std::runtime_error("Reshape failed: element count mismatch");
+    a = a.reshape(nw_shp);
+}
 
-    a.shape = nw_shp;        
-    a.computeStrides();
+// Views sharing a's storage
+static PvT slice(const PvT& a, size_t axis, size_t begin, size_t end, size_t step = 1) {
+    return a.slice(axis, begin, end, step);
 }
 
+static PvT transpose(const PvT& a) { return a.transpose(); }
+static PvT transpose(const PvT& a, const std::vector<size_t>& perm) { return a.transpose(perm); }
+static PvT expand(const PvT& a, const std::vector<size_t>& shp) { return a.expand(shp); }
+
+// Whole tensor: filled in place when a owns contiguous storage, otherwise
+// fresh storage, since the old values are never read
 static void assign(PvT& a, T value) {
-    std::fill(a.data.begin(), a.data.end(), value);
+    if (!a.buf) throw std::runtime_error("assign of empty tensor");
+    if (a.unique() && a.is_contiguous()) std::fill(a.buf->ptr + a.offset, a.buf->ptr + a.offset + a.count(), value);
+    else a = PvT(a.shape, value);
 }
 
 static PvT assign(const PvT& a, T value) {
-    PvT result = a; 
-    std::fill(result.data.begin(), result.data.end(), value);
-    return result;
+    if (!a.buf) throw std::runtime_error("assign of empty tensor");
+    return PvT(a.shape, value);
 }
-// In-place
+// In-place, [start, end) per axis. Walks only the region
 static void assign(PvT& a,
                    const std::vector<size_t>& start,
                    const std::vector<size_t>& end,
                    T value) {
-    // ... validasi start/end seperti sebelumnya
-    for (size_t idx = 0; idx < a.data.size(); ++idx) {
-        bool inside = true;
-        size_t tmp = idx;
-        for (size_t d = 0; d < a.shape.size(); ++d) {
-            size_t pos = tmp / a.strides[d];
-            tmp %= a.strides[d];
-            if (pos < start[d] || pos >= end[d]) { inside = false; break; }
-        }
-        if (inside) a.data[idx] = value;
+    if (!a.buf) throw std::runtime_error("assign of empty tensor");
+    size_t nd = a.shape.size();
+    if (start.size() != nd || end.size() != nd)
+        throw std::runtime_error("assign: region rank mismatch");
+    std::vector<size_t> ext(nd);
+    for (size_t d = 0; d < nd; ++d) {
+        if (start[d] > end[d] || end[d] > a.shape[d])
+            throw std::runtime_error("assign: region out of range");
+        ext[d] = end[d] - start[d];
     }
+
+    T* base = a.mutable_data() - a.offset;   // COW, now contiguous
+    size_t first = a.offset;
+    for (size_t d = 0; d < nd; ++d) first += start[d] * a.strides[d];
+    for_each_run(ext, a.strides, first, [&](size_t off, size_t n, size_t st) {
+        if (st == 1) std::fill(base + off, base + off + n, value);
+        else for (size_t i = 0; i < n; ++i) base[off + i * st] = value;
+    });
 }
 
 // Return new PvT
@@ -0,0 +1,452 @@
+#pragma once
+
+#include "quant.tpp"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#if defined(_WIN32)
+#include <fstream>
+#include <new>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* Binary tensor archive.
+   Many named tensors in one file, laid out so a reader can mmap it and
+   hand out tensors that point straight into the mapping:
+       [0, 64)          header: magic, version, entry count, directory
+       [64, dir)        payloads, each starting on a 64-byte boundary
+       [dir, dir+size)  directory, one record per tensor
+   Record: u32 name_len, u32 dtype, u32 rank, u32 nq, u64 offset,
+           u64 nbytes, u64 shape[rank], u64 strides[rank], u64 qaxis,
+           f32 scale[nq], i32 zero_point[nq], name bytes
+   Strides are in elements. All fields are little-endian. The header is
+   written last, so a file cut short by a crash is rejected on open. */
+
+template <typename T> class Tensor;
+template <typename Q> class QTensor;
+class HalfTensor;
+
+enum class DType : uint32_t { F32 = 1, F64, I8, U8, I16, U16, I32, U32, I64, U64, F16 };
+
+template <typename T>
+constexpr DType dtype_of() {
+    if constexpr (std::is_same<T, float>::value) return DType::F32;
+    else if constexpr (std::is_same<T, double>::value) return DType::F64;
+    else if constexpr (std::is_same<T, Half>::value) return DType::F16;
+    else {
+        static_assert(std::is_integral<T>::value && !std::is_same<T, bool>::value, "archive: unsupported element type");
+        constexpr bool s = std::is_signed<T>::value;
+        if constexpr (sizeof(T) == 1) return s ? DType::I8 : DType::U8;
+        else if constexpr (sizeof(T) == 2) return s ? DType::I16 : DType::U16;
+        else if constexpr (sizeof(T) == 4) return s ? DType::I32 : DType::U32;
+        else return s ? DType::I64 : DType::U64;
+    }
+}
+
+inline size_t dtype_size(DType d) {
+    switch (d) {
+    case DType::I8: case DType::U8: return 1;
+    case DType::I16: case DType::U16: case DType::F16: return 2;
+    case DType::F32: case DType::I32: case DType::U32: return 4;
+    case DType::F64: case DType::I64: case DType::U64: return 8;
+    }
+    return 0;
+}
+
+struct ArchiveHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;        // reserved, 0
+    uint64_t count;
+    uint64_t dir_offset;
+    uint64_t dir_size;
+    uint64_t file_size;
+    uint8_t pad[16];
+};
+static_assert(sizeof(ArchiveHeader) == 64, "archive header must fill one 64-byte block");
+
+struct ArchiveEntry {
+    std::string name;
+    DType dtype = DType::F32;
+    std::vector<size_t> shape;
+    std::vector<size_t> strides;
+    uint64_t offset = 0;   // payload position in the file
+    uint64_t nbytes = 0;
+    bool quantized = false;
+    QParams q;
+};
+
+namespace archive {
+
+constexpr char kMagic[8] = { 'F', 'T', 'A', 'R', 'C', 'H', 'V', '\0' };
+constexpr uint32_t kVersion = 1;
+constexpr uint64_t kAlign = 64;
+
+inline void require_little_endian() {
+    const uint16_t probe = 1;
+    uint8_t low;
+    std::memcpy(&low, &probe, 1);
+    if (low != 1) throw std::runtime_error("archive: big-endian hosts are not supported");
+}
+
+inline uint64_t align_up(uint64_t x) { return (x + kAlign - 1) / kAlign * kAlign; }
+
+// ------------------------------
+// Read-only file image: mmap, or an aligned heap copy where mmap is missing
+// ------------------------------
+struct MappedFile {
+    const char* base = nullptr;
+    size_t size = 0;
+
+    explicit MappedFile(const std::string& path) {
+#if defined(_WIN32)
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) throw std::runtime_error("archive: cannot open " + path);
+        size = size_t(in.tellg());
+        char* p = static_cast<char*>(::operator new(std::max<size_t>(size, 1), std::align_val_t(kAlign)));
+        in.seekg(0);
+        if (!in.read(p, std::streamsize(size))) {
+            ::operator delete(p, std::align_val_t(kAlign));
+            throw std::runtime_error("archive: cannot read " + path);
+        }
+        base = p;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::runtime_error("archive: cannot open " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            throw std::runtime_error("archive: cannot stat " + path);
+        }
+        size = size_t(st.st_size);
+        // Private read-only mapping, pages come in on first touch
+        void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) throw std::runtime_error("archive: cannot map " + path);
+        base = static_cast<const char*>(p);
+#endif
+    }
+
+    ~MappedFile() {
+#if defined(_WIN32)
+        ::operator delete(const_cast<char*>(base), std::align_val_t(kAlign));
+#else
+        ::munmap(const_cast<char*>(base), size);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Ask the kernel to start reading [off, off + len) ahead of use
+    void prefetch(uint64_t off, uint64_t len) const {
+#if !defined(_WIN32)
+        static const uint64_t page = uint64_t(::sysconf(_SC_PAGESIZE));
+        uint64_t lo = off / page * page;
+        ::madvise(const_cast<char*>(base) + lo, size_t(off + len - lo), MADV_WILLNEED);
+#else
+        (void)off; (void)len;
+#endif
+    }
+};
+
+// Bounds-checked reader over the directory bytes
+struct Cursor {
+    const char* p;
+    const char* end;
+
+    template <typename U>
+    U get() {
+        if (size_t(end - p) < sizeof(U)) throw std::runtime_error("archive: truncated directory");
+        U v;
+        std::memcpy(&v, p, sizeof(U));
+        p += sizeof(U);
+        return v;
+    }
+    std::string bytes(size_t n) {
+        if (size_t(end - p) < n) throw std::runtime_error("archive: truncated directory");
+        std::string s(p, n);
+        p += n;
+        return s;
+    }
+};
+
+template <typename U>
+inline void put(std::vector<char>& out, U v) {
+    const char* b = reinterpret_cast<const char*>(&v);
+    out.insert(out.end(), b, b + sizeof(U));
+}
+
+// Strides that tile exactly count() elements with no gap or overlap
+// (row-major, transposed, permuted): the raw span can be written as is
+template <typename T>
+bool compact(const Pv<T>& x) {
+    std::vector<std::pair<size_t, size_t>> axes;
+    for (size_t d = 0; d < x.shape.size(); ++d)
+        if (x.shape[d] != 1) axes.push_back({ x.strides[d], x.shape[d] });
+    std::sort(axes.begin(), axes.end());
+    size_t expected = 1;
+    for (auto& a : axes) {
+        if (a.first != expected) return false;
+        expected *= a.second;
+    }
+    return true;
+}
+
+} // namespace archive
+
+// =====================
+// TensorArchive: mmap reader, zero-copy read-only tensors
+// =====================
+class TensorArchive {
+public:
+    explicit TensorArchive(const std::string& path) : file(std::make_shared<archive::MappedFile>(path)) {
+        archive::require_little_endian();
+        if (file->size < sizeof(ArchiveHeader)) throw std::runtime_error("archive: file too small: " + path);
+        ArchiveHeader h;
+        std::memcpy(&h, file->base, sizeof h);
+        if (std::memcmp(h.magic, archive::kMagic, sizeof h.magic) != 0)
+            throw std::runtime_error("archive: bad magic (not an archive, or incomplete): " + path);
+        if (h.version != archive::kVersion)
+            throw std::runtime_error("archive: unsupported version " + std::to_string(h.version));
+        if (h.file_size != file->size || h.dir_offset < sizeof h || h.dir_offset > file->size
+            || h.dir_size > file->size - h.dir_offset)
+            throw std::runtime_error("archive: corrupt header: " + path);
+
+        archive::Cursor cur{ file->base + h.dir_offset, file->base + h.dir_offset + h.dir_size };
+        list.reserve(size_t(std::min<uint64_t>(h.count, h.dir_size)));
+        for (uint64_t i = 0; i < h.count; ++i) {
+            ArchiveEntry e = read_entry(cur, h.dir_offset);
+            if (!index.emplace(e.name, list.size()).second)
+                throw std::runtime_error("archive: duplicate tensor '" + e.name + "'");
+            list.push_back(std::move(e));
+        }
+    }
+
+    const std::vector<ArchiveEntry>& entries() const { return list; }
+    size_t size() const { return list.size(); }
+    bool contains(const std::string& name) const { return index.count(name) != 0; }
+
+    std::vector<std::string> names() const {
+        std::vector<std::string> r;
+        for (auto& e : list) r.push_back(e.name);
+        return r;
+    }
+
+    const ArchiveEntry& entry(const std::string& name) const {
+        auto it = index.find(name);
+        if (it == index.end()) throw std::runtime_error("archive: no tensor named '" + name + "'");
+        return list[it->second];
+    }
+
+    // Read-only view into the mapping; the mapping outlives this archive
+    // for as long as any view holds it. Writes detach a private copy.
+    template <typename T>
+    Pv<T> view(const std::string& name) const {
+        const ArchiveEntry& e = entry(name);
+        if (e.dtype != dtype_of<T>())
+            throw std::runtime_error("archive: dtype mismatch for '" + name + "'");
+        T* p = reinterpret_cast<T*>(const_cast<char*>(file->base + e.offset));
+        Pv<T> r;
+        r.buf = std::make_shared<Buffer<T>>(p, size_t(e.nbytes / sizeof(T)), file, false);
+        r.shape = e.shape;
+        r.strides = e.strides;
+        return r;
+    }
+
+    void prefetch(const std::string& name) const {
+        const ArchiveEntry& e = entry(name);
+        if (e.nbytes) file->prefetch(e.offset, e.nbytes);
+    }
+
+    // Defined in FTensor.tpp
+    template <typename T> Tensor<T> get(const std::string& name) const;
+    template <typename Q> QTensor<Q> get_quantized(const std::string& name) const;
+    HalfTensor get_half(const std::string& name) const;
+
+private:
+    std::shared_ptr<const archive::MappedFile> file;
+    std::vector<ArchiveEntry> list;
+    std::unordered_map<std::string, size_t> index;
+
+    static ArchiveEntry read_entry(archive::Cursor& cur, uint64_t payload_end) {
+        ArchiveEntry e;
+        uint32_t name_len = cur.get<uint32_t>();
+        e.dtype = DType(cur.get<uint32_t>());
+        uint32_t rank = cur.get<uint32_t>();
+        uint32_t nq = cur.get<uint32_t>();
+        e.offset = cur.get<uint64_t>();
+        e.nbytes = cur.get<uint64_t>();
+        if (rank > 64) throw std::runtime_error("archive: corrupt rank");
+        for (uint32_t d = 0; d < rank; ++d) e.shape.push_back(size_t(cur.get<uint64_t>()));
+        for (uint32_t d = 0; d < rank; ++d) e.strides.push_back(size_t(cur.get<uint64_t>()));
+        uint64_t qaxis = cur.get<uint64_t>();
+        if (nq > 1 && (rank == 0 || qaxis >= rank || nq != e.shape[size_t(qaxis)]))
+            throw std::runtime_error("archive: corrupt quantization parameters");
+        if (nq) { e.q.scale.clear(); e.q.zero_point.clear(); }
+        for (uint32_t i = 0; i < nq; ++i) e.q.scale.push_back(cur.get<float>());
+        for (uint32_t i = 0; i < nq; ++i) e.q.zero_point.push_back(cur.get<int32_t>());
+        e.name = cur.bytes(name_len);
+
+        size_t es = dtype_size(e.dtype);
+        if (es == 0) throw std::runtime_error("archive: unknown dtype for '" + e.name + "'");
+        if (e.offset % archive::kAlign || e.offset < sizeof(ArchiveHeader) || e.offset > payload_end
+            || e.nbytes > payload_end - e.offset || e.nbytes % es)
+            throw std::runtime_error("archive: payload out of bounds for '" + e.name + "'");
+
+        // The furthest element the strides reach must lie inside the payload
+        uint64_t reach = 0, elems = 1;
+        for (uint32_t d = 0; d < rank; ++d) {
+            if (e.shape[d] == 0) { elems = 0; break; }
+            uint64_t span = uint64_t(e.shape[d] - 1) * e.strides[d];
+            if (e.strides[d] && span / e.strides[d] != e.shape[d] - 1) elems = UINT64_MAX;
+            reach += span;
+            if (reach < span) elems = UINT64_MAX;
+        }
+        if (elems && (elems == UINT64_MAX || reach >= e.nbytes / es))
+            throw std::runtime_error("archive: strides exceed payload for '" + e.name + "'");
+
+        if (nq) {
+            e.quantized = true;
+            e.q.axis = size_t(qaxis);
+        }
+        return e;
+    }
+};
+
+// =====================
+// ArchiveWriter: streaming, one tensor in flight at a time
+// =====================
+class ArchiveWriter {
+public:
+    explicit ArchiveWriter(const std::string& path) : path(path) {
+        archive::require_little_endian();
+        f = std::fopen(path.c_str(), "wb");
+        if (!f) throw std::runtime_error("archive: cannot create " + path);
+        // Placeholder header: the file is invalid until finish() fills it
+        pad_to(sizeof(ArchiveHeader));
+    }
+
+    ~ArchiveWriter() {
+        try { finish(); } catch (...) {}
+    }
+
+    ArchiveWriter(const ArchiveWriter&) = delete;
+    ArchiveWriter& operator=(const ArchiveWriter&) = delete;
+
+    // Payload goes to disk now; only the directory record is kept.
+    // Row-major and permuted layouts are written as is, others compacted.
+    template <typename T>
+    void write(const std::string& name, const Pv<T>& x, const QParams* q = nullptr) {
+        if (!f) throw std::runtime_error("archive: writer already finished");
+        if (!x.buf) throw std::runtime_error("archive: tensor '" + name + "' has no storage");
+        if (!names.insert(name).second) throw std::runtime_error("archive: duplicate tensor '" + name + "'");
+
+        ArchiveEntry e;
+        e.name = name;
+        e.dtype = dtype_of<T>();
+        e.shape = x.shape;
+        pad_to(archive::align_up(pos));
+        e.offset = pos;
+        size_t n = x.size();
+        if (archive::compact(x)) {
+            e.strides = x.strides;
+            emit(x.buf->ptr + x.offset, n * sizeof(T));
+        } else {
+            Pv<T> rm;
+            rm.shape = x.shape;
+            rm.computeStrides();
+            e.strides = rm.strides;
+            // Gather through a small staging block instead of a full copy
+            std::vector<T> stage(std::min<size_t>(n, kStage));
+            size_t fill = 0;
+            const T* src = x.buf->ptr;
+            for_each_run(x.shape, x.strides, x.offset, [&](size_t off, size_t cnt, size_t st) {
+                for (size_t i = 0; i < cnt; ++i) {
+                    stage[fill++] = src[off + i * st];
+                    if (fill == stage.size()) { emit(stage.data(), fill * sizeof(T)); fill = 0; }
+                }
+            });
+            if (fill) emit(stage.data(), fill * sizeof(T));
+        }
+        e.nbytes = n * sizeof(T);
+        if (q) {
+            if (q->scale.empty() || q->zero_point.size() != q->scale.size())
+                throw std::runtime_error("archive: bad quantization parameters for '" + name + "'");
+            e.quantized = true;
+            e.q = *q;
+        }
+        list.push_back(std::move(e));
+    }
+
+    // Defined in FTensor.tpp
+    template <typename T> void add(const std::string& name, const Tensor<T>& x);
+    template <typename Q> void add(const std::string& name, const QTensor<Q>& x);
+    void add(const std::string& name, const HalfTensor& x);
+
+    // Writes the directory and header and closes the file
+    void finish() {
+        if (!f) return;
+        std::vector<char> dir;
+        for (auto& e : list) {
+            uint32_t nq = e.quantized ? uint32_t(e.q.scale.size()) : 0;
+            archive::put(dir, uint32_t(e.name.size()));
+            archive::put(dir, uint32_t(e.dtype));
+            archive::put(dir, uint32_t(e.shape.size()));
+            archive::put(dir, nq);
+            archive::put(dir, uint64_t(e.offset));
+            archive::put(dir, uint64_t(e.nbytes));
+            for (auto s : e.shape) archive::put(dir, uint64_t(s));
+            for (auto s : e.strides) archive::put(dir, uint64_t(s));
+            archive::put(dir, uint64_t(e.q.axis));
+            for (uint32_t i = 0; i < nq; ++i) archive::put(dir, e.q.scale[i]);
+            for (uint32_t i = 0; i < nq; ++i) archive::put(dir, e.q.zero_point[i]);
+            dir.insert(dir.end(), e.name.begin(), e.name.end());
+        }
+        pad_to(archive::align_up(pos));
+
+        ArchiveHeader h{};
+        std::memcpy(h.magic, archive::kMagic, sizeof h.magic);
+        h.version = archive::kVersion;
+        h.count = list.size();
+        h.dir_offset = pos;
+        h.dir_size = dir.size();
+        emit(dir.data(), dir.size());
+        h.file_size = pos;
+
+        bool ok = std::fseek(f, 0, SEEK_SET) == 0 && std::fwrite(&h, sizeof h, 1, f) == 1;
+        ok = std::fclose(f) == 0 && ok;
+        f = nullptr;
+        if (!ok) throw std::runtime_error("archive: write failed: " + path);
+    }
+
+private:
+    static constexpr size_t kStage = 16384;
+
+    std::string path;
+    std::FILE* f = nullptr;
+    uint64_t pos = 0;
+    std::vector<ArchiveEntry> list;
+    std::unordered_set<std::string> names;
+
+    void emit(const void* p, size_t n) {
+        if (n && std::fwrite(p, 1, n, f) != n) {
+            std::fclose(f);
+            f = nullptr;
+            throw std::runtime_error("archive: write failed: " + path);
+        }
+        pos += n;
+    }
+
+    void pad_to(uint64_t target) {
+        static const char zeros[archive::kAlign] = {};
+        while (pos < target) emit(zeros, size_t(std::min<uint64_t>(target - pos, archive::kAlign)));
+    }
+};
@@ -0,0 +1,259 @@
+#include "FTensor.tpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+/* fasttensor_bench [--quick] [--filter TEXT] [--threads 1,2,4] [--trace FILE]
+
+   Sweeps one dimension at a time around a default case (float, 4M
+   elements, same-shape operands, chain of 2, all threads):
+     ew      element-wise chains: size, dtype, broadcast shape, chain length
+     reduce  fused full reductions and axis reductions
+     assign  region assign
+     gemm    matmul and linear, fp32 / int8 / fp16 weights
+     math    lazy transcendental ops, softmax and norms along an axis
+   every group repeated for each thread count. Reports the best of several
+   timed runs as GB/s (bytes read + written) and GFLOP/s (element ops).
+   --trace turns on the op profiler and writes a Chrome trace. */
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    bool quick = false;
+    std::string filter;
+    std::vector<size_t> threads;
+    std::string trace;
+};
+
+static Options opt;
+
+// Best time in seconds over runs that together take at least min_time
+template <typename F>
+static double best_time(F&& f) {
+    const double min_time = opt.quick ? 0.05 : 0.3;
+    f();   // warm up: page in, grow the pool
+    double best = 1e30, total = 0;
+    int runs = 0;
+    while (total < min_time || runs < 3) {
+        auto t0 = Clock::now();
+        f();
+        double s = std::chrono::duration<double>(Clock::now() - t0).count();
+        best = std::min(best, s);
+        total += s;
+        if (++runs >= 1000) break;
+    }
+    return best;
+}
+
+static void report(const char* group, const std::string& name, const char* dtype, size_t n,
+                   double sec, double bytes, double flops) {
+    std::printf("%-7s %-28s %-6s %10zu %4zu %12.2f %9.2f %9.2f\n", group, name.c_str(), dtype, n,
+                Executor::global().num_threads(), sec * 1e6, bytes / sec / 1e9, flops / sec / 1e9);
+}
+
+static bool selected(const char* group, const std::string& name) {
+    return opt.filter.empty() || (std::string(group) + " " + name).find(opt.filter) != std::string::npos;
+}
+
+template <typename T> const char* dtype_name();
+template <> const char* dtype_name<float>() { return "f32"; }
+template <> const char* dtype_name<double>() { return "f64"; }
+template <> const char* dtype_name<int32_t>() { return "i32"; }
+
+// ------------------------------
+// Element-wise: core [rows, cols] op= operand, chain ops long
+// ------------------------------
+template <typename T>
+static void elementwise(const char* bcast, size_t n, size_t chain) {
+    std::string name = std::string("chain") + std::to_string(chain) + " " + bcast;
+    if (!selected("ew", name)) return;
+    size_t cols = 1024, rows = std::max<size_t>(1, n / cols);
+    n = rows * cols;
+    std::vector<size_t> oshape;
+    size_t operand_elems;
+    if (!std::strcmp(bcast, "same"))        { oshape = { rows, cols }; operand_elems = n; }
+    else if (!std::strcmp(bcast, "row"))    { oshape = { cols };       operand_elems = cols; }
+    else if (!std::strcmp(bcast, "col"))    { oshape = { rows, 1 };    operand_elems = rows; }
+    else                                    { oshape = { 1 };          operand_elems = 1; }
+
+    auto a = Tensor<T>::fill({ rows, cols }, T(1));
+    auto b = Tensor<T>::fill(oshape, T(1));
+    double sec = best_time([&] {
+        Tensor<T> r = a;
+        for (size_t k = 0; k < chain; ++k) {
+            if (k % 2) r.mul(b);
+            else r.add(b);
+        }
+        r.evaluate();
+    });
+    // core read + result written, the operand once per op
+    double bytes = double(sizeof(T)) * (2.0 * n + double(operand_elems) * chain);
+    report("ew", name, dtype_name<T>(), n, sec, bytes, double(n) * chain);
+}
+
+// ------------------------------
+// Reductions
+// ------------------------------
+template <typename T>
+static void reductions(size_t n) {
+    size_t cols = 1024, rows = std::max<size_t>(1, n / cols);
+    n = rows * cols;
+    auto a = Tensor<T>::fill({ rows, cols }, T(1));
+    double bytes = double(sizeof(T)) * n;
+    if (selected("reduce", "sum")) report("reduce", "sum", dtype_name<T>(), n, best_time([&] { a.sum(); }), bytes, double(n));
+    if (selected("reduce", "mean+var+argmax")) {
+        double sec = best_time([&] { a.stats({ StatKind::Mean, StatKind::Var, StatKind::ArgMax }); });
+        report("reduce", "mean+var+argmax", dtype_name<T>(), n, sec, bytes, 3.0 * n);
+    }
+    if (selected("reduce", "sum axis0")) report("reduce", "sum axis0", dtype_name<T>(), n, best_time([&] { a.sum({ 0 }); }), bytes, double(n));
+    if (selected("reduce", "sum axis1")) report("reduce", "sum axis1", dtype_name<T>(), n, best_time([&] { a.sum({ 1 }); }), bytes, double(n));
+}
+
+// ------------------------------
+// Region assign, a quarter of the tensor
+// ------------------------------
+template <typename T>
+static void region_assign(size_t n) {
+    if (!selected("assign", "region")) return;
+    size_t cols = 1024, rows = std::max<size_t>(2, n / cols);
+    n = rows * cols;
+    auto a = Tensor<T>::fill({ rows, cols }, T(0));
+    double sec = best_time([&] { a.assign({ rows / 4, cols / 4 }, { rows * 3 / 4, cols * 3 / 4 }, T(1)); });
+    report("assign", "region", dtype_name<T>(), n / 4, sec, double(sizeof(T)) * (n / 4), 0.0);
+}
+
+// ------------------------------
+// GEMM: m x k times k x n
+// ------------------------------
+static void gemm(size_t m, size_t n, size_t k) {
+    std::string shape = std::to_string(m) + "x" + std::to_string(n) + "x" + std::to_string(k);
+    double flops = 2.0 * m * n * k;
+    auto a = Tensor<float>::random(-1.f, 1.f, { m, k });
+    auto w = Tensor<float>::random(-1.f, 1.f, { n, k });
+    if (selected("gemm", "matmul " + shape)) {
+        auto b = w.transpose().contiguous();
+        double sec = best_time([&] { a.matmul(b); });
+        report("gemm", "matmul " + shape, "f32", m * n, sec, 4.0 * (m * k + k * n + m * n), flops);
+    }
+    if (selected("gemm", "linear " + shape)) {
+        double sec = best_time([&] { a.linear(w); });
+        report("gemm", "linear " + shape, "f32", m * n, sec, 4.0 * (m * k + k * n + m * n), flops);
+    }
+    if (selected("gemm", "linear.int8 " + shape)) {
+        auto q = QTensor<int8_t>::quantize(w, true, 0);
+        double sec = best_time([&] { a.linear(q); });
+        report("gemm", "linear.int8 " + shape, "i8", m * n, sec, 4.0 * (m * k + m * n) + double(k) * n, flops);
+    }
+    if (selected("gemm", "linear.fp16 " + shape)) {
+        HalfTensor h(w);
+        double sec = best_time([&] { a.linear(h); });
+        report("gemm", "linear.fp16 " + shape, "f16", m * n, sec, 4.0 * (m * k + m * n) + 2.0 * k * n, flops);
+    }
+}
+
+// ------------------------------
+// Math: one lazy unary op, and the fused axis kernels on [rows, 1024]
+// ------------------------------
+template <typename T>
+static void math(size_t n) {
+    size_t cols = 1024, rows = std::max<size_t>(1, n / cols);
+    n = rows * cols;
+    auto a = Tensor<T>::random(T(-4), T(4), { rows, cols });
+    double bytes = 2.0 * sizeof(T) * n;
+    auto unary = [&](const char* name, Tensor<T>& (Tensor<T>::*op)()) {
+        if (!selected("math", name)) return;
+        double sec = best_time([&] { Tensor<T> r = a; (r.*op)(); r.evaluate(); });
+        report("math", name, dtype_name<T>(), n, sec, bytes, double(n));
+    };
+    unary("exp", &Tensor<T>::exp);
+    unary("log", &Tensor<T>::log);
+    unary("sin", &Tensor<T>::sin);
+    unary("tanh", &Tensor<T>::tanh);
+    unary("sigmoid", &Tensor<T>::sigmoid);
+    unary("gelu", &Tensor<T>::gelu);
+    if (selected("math", "pow 2.5")) {
+        double sec = best_time([&] { Tensor<T> r = a; r.pow(T(2.5)); r.evaluate(); });
+        report("math", "pow 2.5", dtype_name<T>(), n, sec, bytes, double(n));
+    }
+    auto axis = [&](const char* name, size_t ax, auto&& f) {
+        if (!selected("math", name)) return;
+        report("math", name, dtype_name<T>(), n, best_time([&] { f(ax); }), bytes, 5.0 * n);
+    };
+    axis("softmax axis1", 1, [&](size_t ax) { a.softmax(ax); });
+    axis("softmax axis0", 0, [&](size_t ax) { a.softmax(ax); });
+    axis("log_softmax axis1", 1, [&](size_t ax) { a.log_softmax(ax); });
+    axis("layernorm axis1", 1, [&](size_t ax) { a.layernorm(ax); });
+    axis("rmsnorm axis1", 1, [&](size_t ax) { a.rmsnorm(ax); });
+}
+
+static void run_all() {
+    const size_t def = opt.quick ? (size_t(1) << 20) : (size_t(1) << 22);
+    std::vector<size_t> sizes = opt.quick ? std::vector<size_t>{ 1 << 12, 1 << 16, 1 << 20 }
+                                          : std::vector<size_t>{ 1 << 12, 1 << 16, 1 << 20, 1 << 22, 1 << 24 };
+
+    for (size_t n : sizes) elementwise<float>("same", n, 2);
+    elementwise<double>("same", def, 2);
+    elementwise<int32_t>("same", def, 2);
+    for (const char* b : { "row", "col", "scalar" }) elementwise<float>(b, def, 2);
+    for (size_t c : { 1, 4, 8, 16 }) elementwise<float>("same", def, c);
+
+    for (size_t n : sizes) reductions<float>(n);
+    reductions<double>(def);
+    reductions<int32_t>(def);
+
+    region_assign<float>(def);
+    region_assign<double>(def);
+
+    math<float>(def);
+    math<double>(def);
+
+    gemm(1, 4096, 4096);
+    gemm(opt.quick ? 128 : 512, opt.quick ? 128 : 512, opt.quick ? 128 : 512);
+    if (!opt.quick) gemm(1024, 1024, 1024);
+}
+
+static std::vector<size_t> parse_list(const char* s) {
+    std::vector<size_t> r;
+    while (*s) {
+        char* end;
+        r.push_back(std::strtoul(s, &end, 10));
+        s = *end ? end + 1 : end;
+    }
+    return r;
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--quick") opt.quick = true;
+        else if (a == "--filter" && i + 1 < argc) opt.filter = argv[++i];
+        else if (a == "--threads" && i + 1 < argc) opt.threads = parse_list(argv[++i]);
+        else if (a == "--trace" && i + 1 < argc) opt.trace = argv[++i];
+        else {
+            std::fprintf(stderr, "usage: %s [--quick] [--filter TEXT] [--threads 1,2,4] [--trace FILE]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (opt.threads.empty()) {
+        size_t hw = std::max<size_t>(1, std::thread::hardware_concurrency());
+        for (size_t t = 1; t < hw; t *= 2) opt.threads.push_back(t);
+        opt.threads.push_back(hw);
+    }
+    if (!opt.trace.empty()) Profiler::global().enable();
+
+    std::printf("isa %s, int8 dot %s\n", simd::isa_name(simd::active_isa()), simd::quant_kernels().dot_isa);
+    std::printf("%-7s %-28s %-6s %10s %4s %12s %9s %9s\n", "group", "case", "dtype", "elems", "thr", "best us", "GB/s", "GFLOP/s");
+    for (size_t t : opt.threads) {
+        ExecutorConfig cfg;
+        cfg.threads = t;
+        Executor::global().configure(cfg);
+        run_all();
+    }
+
+    if (!opt.trace.empty()) {
+        Profiler::global().report();
+        Profiler::global().write_chrome_trace(opt.trace);
+        std::printf("trace written to %s\n", opt.trace.c_str());
+    }
+}
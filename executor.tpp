@@ -0,0 +1,416 @@
+#pragma once
+
+#include "pch.tpp"
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+/* Process-wide work-stealing executor.
+   Persistent workers, one lock-free deque each (Chase-Lev). parallel_for
+   splits a range in halves down to the grain size; idle workers steal the
+   largest pending halves. Both lazy engines run on Executor::global(). */
+
+// =====================
+// ExecutorConfig
+// =====================
+struct ExecutorConfig {
+    size_t threads = 0;           // participants incl. the calling thread, 0 -> hardware
+    std::vector<int> cpus;        // worker thread k (slot k >= 1) is pinned to cpus[(k - 1) % size];
+                                  // calling threads are never pinned. Empty -> unpinned
+    size_t serial_cutoff = 32768; // ranges with items * cost below this run inline
+};
+
+// =====================
+// WorkDeque (Chase-Lev, fixed capacity)
+// =====================
+template <typename Item>
+struct WorkDeque {
+    static constexpr int64_t kCap = 1024;
+
+    std::atomic<int64_t> top{0};
+    std::atomic<int64_t> bottom{0};
+    std::atomic<Item*> buf[kCap];
+
+    // Owner only. false when full, caller runs the item itself
+    bool push(Item* it) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        if (b - t >= kCap) return false;
+        buf[b & (kCap - 1)].store(it, std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Owner only, LIFO end
+    Item* pop() {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        Item* it = buf[b & (kCap - 1)].load(std::memory_order_relaxed);
+        if (t == b) {
+            // Last item: race against thieves
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                             std::memory_order_relaxed))
+                it = nullptr;
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return it;
+    }
+
+    // Any thread, racy: a hint for whether to sleep
+    bool maybe_nonempty() const {
+        return bottom.load(std::memory_order_seq_cst) > top.load(std::memory_order_seq_cst);
+    }
+
+    // Any thread, FIFO end
+    Item* steal() {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return nullptr;
+        Item* it = buf[t & (kCap - 1)].load(std::memory_order_acquire);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                         std::memory_order_relaxed))
+            return nullptr;
+        return it;
+    }
+};
+
+// =====================
+// Executor
+// =====================
+class Executor {
+public:
+    static constexpr size_t npos = size_t(-1);
+    static constexpr size_t kSpinRounds = 256;   // idle polls before a worker sleeps
+
+    explicit Executor(const ExecutorConfig& cfg = ExecutorConfig()) { start(cfg); }
+    ~Executor() { shutdown(); }
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    // Shared by the whole process. FT_NUM_THREADS overrides the thread count
+    static Executor& global() {
+        static Executor ex(env_config());
+        return ex;
+    }
+
+    // Restart with a new configuration. Must not race with running work
+    void configure(const ExecutorConfig& cfg) {
+        shutdown();
+        start(cfg);
+    }
+
+    size_t num_threads() const { return slots.size(); }
+    size_t serial_cutoff() const { return config.serial_cutoff; }
+    const ExecutorConfig& settings() const { return config; }
+    // Slot of the calling thread inside a parallel_for, npos outside
+    size_t current_worker() const { return current_slot(); }
+
+    // ------------------------------
+    // body(b, e) over [begin, end) in pieces of at least grain items.
+    // Runs inline when items * cost is under the serial cutoff.
+    // ------------------------------
+    template <typename F>
+    void parallel_for(size_t begin, size_t end, size_t grain, F&& body, size_t cost = 1) {
+        if (end <= begin) return;
+        if (grain == 0) grain = 1;
+        size_t n = end - begin;
+        if (slots.size() <= 1 || n <= grain || n * cost < config.serial_cutoff) {
+            body(begin, end);
+            return;
+        }
+
+        using Fn = typename std::remove_reference<F>::type;
+        Job job;
+        job.invoke = [](void* ctx, size_t b, size_t e) { (*static_cast<Fn*>(ctx))(b, e); };
+        job.ctx = const_cast<void*>(static_cast<const void*>(&body));
+        job.grain = grain;
+        job.pending.store(1, std::memory_order_relaxed);
+        Task* root = new Task{ &job, begin, end };
+
+        // External callers borrow slot 0 when it is free
+        size_t slot = current_slot();
+        bool master = false;
+        if (slot == npos && master_mutex.try_lock()) {
+            master = true;
+            slot = 0;
+            tls_owner() = this;
+            tls_slot() = 0;
+        }
+
+        begin_job();
+        if (slot != npos) run_task(root, slot);
+        else inject(root);
+        while (job.pending.load(std::memory_order_acquire) != 0) {
+            Task* t = find_task(slot);
+            if (t) run_task(t, slot);
+            else std::this_thread::yield();
+        }
+        end_job();
+
+        if (master) {
+            tls_owner() = nullptr;
+            tls_slot() = npos;
+            master_mutex.unlock();
+        }
+        if (job.error) std::rethrow_exception(job.error);
+    }
+
+    // ------------------------------
+    // Deterministic reduction: fixed chunks of grain items, each mapped
+    // to R by map(b, e), then combined pairwise in a fixed tree order.
+    // The result does not depend on the thread count.
+    // ------------------------------
+    template <typename R, typename Map, typename Combine>
+    R parallel_reduce(size_t begin, size_t end, size_t grain, R identity,
+                      Map&& map, Combine&& combine, size_t cost = 1) {
+        if (end <= begin) return identity;
+        if (grain == 0) grain = 1;
+        size_t chunks = (end - begin + grain - 1) / grain;
+        std::vector<R> partial(chunks, identity);
+
+        parallel_for(0, chunks, 1, [&](size_t cb, size_t ce) {
+            for (size_t c = cb; c < ce; ++c) {
+                size_t b = begin + c * grain;
+                partial[c] = map(b, std::min(b + grain, end));
+            }
+        }, grain * cost);
+
+        for (size_t step = 1; step < chunks; step *= 2)
+            for (size_t i = 0; i + step < chunks; i += 2 * step)
+                partial[i] = combine(partial[i], partial[i + step]);
+        return partial[0];
+    }
+
+    // Cores with the highest max frequency (big cluster on big.LITTLE).
+    // Empty when cpufreq is not readable.
+    static std::vector<int> big_cores() {
+        std::vector<int> cpus;
+        std::vector<long> freq;
+        size_t hw = std::thread::hardware_concurrency();
+        for (size_t c = 0; c < hw; ++c) {
+            std::ifstream f("/sys/devices/system/cpu/cpu" + std::to_string(c) +
+                            "/cpufreq/cpuinfo_max_freq");
+            long khz = 0;
+            if (!(f >> khz)) return {};
+            cpus.push_back(int(c));
+            freq.push_back(khz);
+        }
+        if (freq.empty()) return {};
+        long top_freq = *std::max_element(freq.begin(), freq.end());
+        std::vector<int> big;
+        for (size_t i = 0; i < cpus.size(); ++i)
+            if (freq[i] == top_freq) big.push_back(cpus[i]);
+        return big;
+    }
+
+private:
+    struct Job {
+        void (*invoke)(void*, size_t, size_t);
+        void* ctx;
+        size_t grain;
+        std::atomic<size_t> pending{0};
+        std::exception_ptr error;
+        std::mutex error_mutex;
+    };
+
+    struct Task {
+        Job* job;
+        size_t begin, end;
+    };
+
+    struct Slot {
+        WorkDeque<Task> deque;
+    };
+
+    ExecutorConfig config;
+    std::vector<std::unique_ptr<Slot>> slots;   // slot 0 is the calling thread
+    std::vector<std::thread> workers;           // slots 1..n-1
+    std::mutex master_mutex;
+
+    std::mutex mutex;                           // guards injected, sleep/wake
+    std::condition_variable cv;
+    std::vector<Task*> injected;
+    std::atomic<size_t> injected_count{0};
+    std::atomic<size_t> active{0};
+    std::atomic<size_t> sleepers{0};            // workers blocked on cv
+    size_t wakes = 0;                           // bumped under mutex on every wake
+    bool stop = false;
+
+    static const Executor*& tls_owner() { static thread_local const Executor* o = nullptr; return o; }
+    static size_t& tls_slot() { static thread_local size_t s = npos; return s; }
+
+    size_t current_slot() const { return tls_owner() == this ? tls_slot() : npos; }
+
+    static ExecutorConfig env_config() {
+        ExecutorConfig cfg;
+        if (const char* env = std::getenv("FT_NUM_THREADS")) cfg.threads = std::strtoul(env, nullptr, 10);
+        return cfg;
+    }
+
+    void start(const ExecutorConfig& cfg) {
+        config = cfg;
+        size_t n = cfg.threads ? cfg.threads : std::thread::hardware_concurrency();
+        if (n == 0) n = 4;
+        stop = false;
+        slots.clear();
+        for (size_t i = 0; i < n; ++i) slots.push_back(std::make_unique<Slot>());
+        for (size_t i = 1; i < n; ++i)
+            workers.emplace_back([this, i]() { worker_loop(i); });
+    }
+
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        cv.notify_all();
+        for (auto& w : workers) w.join();
+        workers.clear();
+    }
+
+    void worker_loop(size_t id) {
+        tls_owner() = this;
+        tls_slot() = id;
+        if (!config.cpus.empty()) pin_thread(config.cpus[(id - 1) % config.cpus.size()]);
+
+        size_t idle = 0;
+        while (true) {
+            Task* t = find_task(id);
+            if (t) { run_task(t, id); idle = 0; continue; }
+
+            // Poll a while during a job, then sleep until work is pushed
+            if (active.load(std::memory_order_acquire) != 0 && ++idle < kSpinRounds) {
+                std::this_thread::yield();
+                continue;
+            }
+            idle = 0;
+            std::unique_lock<std::mutex> lock(mutex);
+            if (stop) return;
+            size_t seen = wakes;
+            sleepers.fetch_add(1, std::memory_order_seq_cst);
+            if (!has_work()) cv.wait(lock, [&]() { return stop || wakes != seen; });
+            sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Pairs with the sleepers increment in worker_loop: either the pusher
+    // sees a sleeper or the sleeper sees the task
+    bool has_work() const {
+        if (injected_count.load(std::memory_order_seq_cst) != 0) return true;
+        for (const auto& s : slots)
+            if (s->deque.maybe_nonempty()) return true;
+        return false;
+    }
+
+    void wake(bool all) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++wakes;
+        }
+        if (all) cv.notify_all();
+        else cv.notify_one();
+    }
+
+    static void pin_thread(int cpu) {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        sched_setaffinity(0, sizeof(set), &set);  // 0 -> calling thread
+#else
+        (void)cpu;
+#endif
+    }
+
+    void begin_job() {
+        if (active.fetch_add(1, std::memory_order_acq_rel) == 0) wake(true);
+    }
+
+    void end_job() { active.fetch_sub(1, std::memory_order_acq_rel); }
+
+    void inject(Task* t) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            injected.push_back(t);
+            injected_count.fetch_add(1, std::memory_order_release);
+            ++wakes;
+        }
+        cv.notify_one();
+    }
+
+    Task* find_task(size_t self) {
+        if (self != npos)
+            if (Task* t = slots[self]->deque.pop()) return t;
+
+        // Injected roots only go to slot owners, which can split them; a
+        // caller without a slot would run one whole range serially
+        if (self != npos && injected_count.load(std::memory_order_acquire) != 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!injected.empty()) {
+                Task* t = injected.back();
+                injected.pop_back();
+                injected_count.fetch_sub(1, std::memory_order_release);
+                return t;
+            }
+        }
+
+        size_t n = slots.size();
+        size_t first = self == npos ? 0 : self + 1;
+        for (size_t k = 0; k < n; ++k) {
+            size_t victim = (first + k) % n;
+            if (victim == self) continue;
+            if (Task* t = slots[victim]->deque.steal()) return t;
+        }
+        return nullptr;
+    }
+
+    // Split off right halves onto our deque until the grain is reached,
+    // then run what is left
+    void run_task(Task* t, size_t slot) {
+        Job& job = *t->job;
+        size_t b = t->begin, e = t->end;
+        delete t;
+
+        bool pushed = false;
+        while (slot != npos && e - b > job.grain) {
+            size_t chunks = (e - b + job.grain - 1) / job.grain;
+            size_t mid = b + (chunks / 2) * job.grain;
+            Task* right = new Task{ &job, mid, e };
+            job.pending.fetch_add(1, std::memory_order_relaxed);
+            if (!slots[slot]->deque.push(right)) {
+                job.pending.fetch_sub(1, std::memory_order_relaxed);
+                delete right;
+                break;
+            }
+            e = mid;
+            pushed = true;
+        }
+        if (pushed) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (sleepers.load(std::memory_order_relaxed) != 0) wake(false);
+        }
+
+        try {
+            job.invoke(job.ctx, b, e);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(job.error_mutex);
+            if (!job.error) job.error = std::current_exception();
+        }
+        job.pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+};
@@ -0,0 +1,426 @@
+#pragma once
+
+#include "simd.tpp"
+#include "executor.tpp"
+
+/* Dense matrix products.
+   C = A * B runs as a packed, cache-blocked GEMM in BLIS loop order: B is
+   packed once per KC x NC block and shared by every task, each task packs
+   its own MC x KC block of A, and a SIMD micro-kernel accumulates an
+   MR x NR register tile. Operands are read through (row, col) strides, so
+   transposed and broadcast views need no copy. M == 1 or N == 1 takes the
+   GEMV path, which streams the matrix exactly once. */
+
+// ------------------------------
+// Activation fused after the bias add
+// ------------------------------
+enum class Activation : uint8_t { None, Relu, Sigmoid, Tanh, Gelu };
+
+namespace simd {
+
+#if defined(__clang__)
+#define FT_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__)
+#define FT_UNROLL _Pragma("GCC unroll 16")
+#else
+#define FT_UNROLL
+#endif
+
+// Matrix kernels, expanded in a traits struct from simd.tpp that also
+// defines MR. The register tile is MR x NR with NR = 2 * W; packed panels
+// are laid out a[p * MR + i] and b[p * NR + j].
+#define FT_GEMM_KERNELS(ATTR)                                                   \
+    static constexpr size_t NR = 2 * W;                                         \
+    /* c[MR x NR] = (acc ? c : 0) + a-panel * b-panel over kc */                \
+    ATTR static void micro(size_t kc, const T* a, const T* b, T* c, size_t ldc, \
+                           bool acc) {                                          \
+        V c0[MR], c1[MR];                                                       \
+        FT_UNROLL for (size_t i = 0; i < MR; ++i) {                             \
+            c0[i] = set1(T());                                                  \
+            c1[i] = set1(T());                                                  \
+        }                                                                       \
+        for (size_t p = 0; p < kc; ++p, a += MR, b += NR) {                     \
+            const V b0 = load(b), b1 = load(b + W);                             \
+            FT_UNROLL for (size_t i = 0; i < MR; ++i) {                         \
+                const V ai = set1(a[i]);                                        \
+                c0[i] = fma(ai, b0, c0[i]);                                     \
+                c1[i] = fma(ai, b1, c1[i]);                                     \
+            }                                                                   \
+        }                                                                       \
+        FT_UNROLL for (size_t i = 0; i < MR; ++i) {                             \
+            T* row = c + i * ldc;                                               \
+            if (acc) {                                                          \
+                c0[i] = apply<OpKind::Add>(c0[i], load(row));                   \
+                c1[i] = apply<OpKind::Add>(c1[i], load(row + W));               \
+            }                                                                   \
+            store(row, c0[i]);                                                  \
+            store(row + W, c1[i]);                                              \
+        }                                                                       \
+    }                                                                           \
+    ATTR static T dot(const T* a, const T* b, size_t n) {                       \
+        V s0 = set1(T()), s1 = set1(T()), s2 = set1(T()), s3 = set1(T());       \
+        size_t i = 0;                                                           \
+        for (; i + 4 * W <= n; i += 4 * W) {                                    \
+            s0 = fma(load(a + i), load(b + i), s0);                             \
+            s1 = fma(load(a + i + W), load(b + i + W), s1);                     \
+            s2 = fma(load(a + i + 2 * W), load(b + i + 2 * W), s2);             \
+            s3 = fma(load(a + i + 3 * W), load(b + i + 3 * W), s3);             \
+        }                                                                       \
+        for (; i + W <= n; i += W) s0 = fma(load(a + i), load(b + i), s0);      \
+        T lanes[W];                                                             \
+        store(lanes, apply<OpKind::Add>(apply<OpKind::Add>(s0, s1),             \
+                                        apply<OpKind::Add>(s2, s3)));           \
+        T s = T();                                                              \
+        for (size_t j = 0; j < W; ++j) s += lanes[j];                           \
+        for (; i < n; ++i) s += a[i] * b[i];                                    \
+        return s;                                                               \
+    }                                                                           \
+    /* y += s * x */                                                            \
+    ATTR static void axpy(T s, const T* x, T* y, size_t n) {                    \
+        const V vs = set1(s);                                                   \
+        size_t i = 0;                                                           \
+        for (; i + W <= n; i += W) store(y + i, fma(load(x + i), vs, load(y + i))); \
+        for (; i < n; ++i) y[i] += x[i] * s;                                    \
+    }
+
+// ------------------------------
+// Portable fallback, any arithmetic T
+// ------------------------------
+template <typename T>
+struct GenericGemm {
+    static constexpr size_t MR = 4;
+    static constexpr size_t NR = 4;
+
+    static void micro(size_t kc, const T* a, const T* b, T* c, size_t ldc, bool acc) {
+        T t[MR][NR] = {};
+        for (size_t p = 0; p < kc; ++p, a += MR, b += NR)
+            for (size_t i = 0; i < MR; ++i)
+                for (size_t j = 0; j < NR; ++j) t[i][j] += a[i] * b[j];
+        for (size_t i = 0; i < MR; ++i)
+            for (size_t j = 0; j < NR; ++j)
+                c[i * ldc + j] = acc ? c[i * ldc + j] + t[i][j] : t[i][j];
+    }
+    static T dot(const T* a, const T* b, size_t n) {
+        T s = T();
+        for (size_t i = 0; i < n; ++i) s += a[i] * b[i];
+        return s;
+    }
+    static void axpy(T s, const T* x, T* y, size_t n) {
+        for (size_t i = 0; i < n; ++i) y[i] += x[i] * s;
+    }
+};
+
+// MR per backend: 2 * MR accumulators plus two B vectors and one A
+// broadcast fit the register file (16 vector registers on SSE/AVX2 and
+// ARMv7, 32 on AVX-512 and AArch64).
+#ifdef FT_ARCH_X86
+struct Sse42F32Gemm : Sse42F32 { static constexpr size_t MR = 6; FT_GEMM_KERNELS(FT_SSE42) };
+struct Sse42F64Gemm : Sse42F64 { static constexpr size_t MR = 6; FT_GEMM_KERNELS(FT_SSE42) };
+struct Avx2F32Gemm : Avx2F32 { static constexpr size_t MR = 6; FT_GEMM_KERNELS(FT_AVX2) };
+struct Avx2F64Gemm : Avx2F64 { static constexpr size_t MR = 6; FT_GEMM_KERNELS(FT_AVX2) };
+struct Avx512F32Gemm : Avx512F32 { static constexpr size_t MR = 12; FT_GEMM_KERNELS(FT_AVX512) };
+struct Avx512F64Gemm : Avx512F64 { static constexpr size_t MR = 12; FT_GEMM_KERNELS(FT_AVX512) };
+#endif
+#ifdef FT_ARCH_NEON
+#  if defined(__aarch64__)
+struct NeonF32Gemm : NeonF32 { static constexpr size_t MR = 8; FT_GEMM_KERNELS(FT_NEON) };
+struct NeonF64Gemm : NeonF64 { static constexpr size_t MR = 8; FT_GEMM_KERNELS(FT_NEON) };
+#  else
+struct NeonF32Gemm : NeonF32 { static constexpr size_t MR = 4; FT_GEMM_KERNELS(FT_NEON) };
+#  endif
+#endif
+
+// ------------------------------
+// Dispatch table
+// ------------------------------
+template <typename T>
+struct GemmTable {
+    using Micro = void (*)(size_t, const T*, const T*, T*, size_t, bool);
+    using Dot   = T (*)(const T*, const T*, size_t);
+    using Axpy  = void (*)(T, const T*, T*, size_t);
+
+    Micro micro;
+    Dot dot;
+    Axpy axpy;
+    size_t mr = 0, nr = 0;   // register tile
+    Isa isa = Isa::Scalar;
+};
+
+template <typename T, typename Tr>
+GemmTable<T> make_gemm_table(Isa isa) {
+    GemmTable<T> t;
+    t.micro = &Tr::micro;
+    t.dot = &Tr::dot;
+    t.axpy = &Tr::axpy;
+    t.mr = Tr::MR;
+    t.nr = Tr::NR;
+    t.isa = isa;
+    return t;
+}
+
+template <typename T>
+GemmTable<T> select_gemm_table(Isa isa) {
+    (void)isa;
+#ifdef FT_ARCH_X86
+    if constexpr (std::is_same<T, float>::value) {
+        if (isa == Isa::Avx512) return make_gemm_table<T, Avx512F32Gemm>(isa);
+        if (isa == Isa::Avx2)   return make_gemm_table<T, Avx2F32Gemm>(isa);
+        if (isa == Isa::Sse42)  return make_gemm_table<T, Sse42F32Gemm>(isa);
+    } else if constexpr (std::is_same<T, double>::value) {
+        if (isa == Isa::Avx512) return make_gemm_table<T, Avx512F64Gemm>(isa);
+        if (isa == Isa::Avx2)   return make_gemm_table<T, Avx2F64Gemm>(isa);
+        if (isa == Isa::Sse42)  return make_gemm_table<T, Sse42F64Gemm>(isa);
+    }
+#endif
+#ifdef FT_ARCH_NEON
+    if (isa == Isa::Neon) {
+        if constexpr (std::is_same<T, float>::value) return make_gemm_table<T, NeonF32Gemm>(isa);
+#  if defined(__aarch64__)
+        else if constexpr (std::is_same<T, double>::value) return make_gemm_table<T, NeonF64Gemm>(isa);
+#  endif
+    }
+#endif
+    return make_gemm_table<T, GenericGemm<T>>(Isa::Scalar);
+}
+
+template <typename T>
+const GemmTable<T>& gemm_kernels() {
+    static const GemmTable<T> table = select_gemm_table<T>(active_isa());
+    return table;
+}
+
+} // namespace simd
+
+// =====================
+// Gemm
+// =====================
+// Read-only matrix view: element (i, j) is p[i * rs + j * cs]
+template <typename T>
+struct MatRef {
+    const T* p;
+    size_t rs, cs;
+    T at(size_t i, size_t j) const { return p[i * rs + j * cs]; }
+    MatRef t() const { return { p, cs, rs }; }
+};
+
+// Applied to every output element: act(c + bias[j * bias_stride])
+template <typename T>
+struct Epilogue {
+    const T* bias = nullptr;
+    size_t bias_stride = 0;
+    Activation act = Activation::None;
+
+    bool active() const { return bias || act != Activation::None; }
+};
+
+template <typename T>
+struct Gemm {
+    static constexpr size_t kKC = 256;     // depth of a packed block, panels stay in L1
+    static constexpr size_t kMC = 96;      // rows of a packed A block, L2 resident
+    static constexpr size_t kNC = 2048;    // columns of a packed B block, L3 resident
+    static constexpr size_t kTile = 1024;  // >= MR * NR of every backend
+    static constexpr size_t kChunk = 16384;
+
+    // ------------------------------
+    // c (m x n, row stride ldc) = a (m x k) * b (k x n), then ep
+    // ------------------------------
+    static void run(size_t m, size_t n, size_t k, MatRef<T> a, MatRef<T> b,
+                    T* c, size_t ldc, const Epilogue<T>& ep = Epilogue<T>()) {
+        if (m == 0 || n == 0) return;
+        if (k == 0) {
+            for (size_t i = 0; i < m; ++i) std::fill(c + i * ldc, c + i * ldc + n, T());
+            finish(c, ldc, m, n, 0, ep);
+        } else if (n == 1) {
+            gemv(m, k, a, b.p, b.rs, c, ldc);
+            finish(c, ldc, m, 1, 0, ep);
+        } else if (m == 1) {
+            gemv(n, k, b.t(), a.p, a.cs, c, 1);
+            finish(c, ldc, 1, n, 0, ep);
+        } else {
+            blocked(m, n, k, a, b, c, ldc, ep);
+        }
+    }
+
+    // Flat inner product of n contiguous elements, fixed chunk order
+    static T dot(const T* a, const T* b, size_t n) {
+        const auto& kt = simd::gemm_kernels<T>();
+        return Executor::global().parallel_reduce(0, n, kChunk, T(),
+            [&](size_t lo, size_t hi) { return kt.dot(a + lo, b + lo, hi - lo); },
+            [](T x, T y) { return x + y; });
+    }
+
+    // Scalar reference of the vector kernels finish() uses
+    static T activate(T x, Activation act) {
+        switch (act) {
+            case Activation::Relu:    return x < T() ? T() : x;
+            case Activation::Sigmoid: return static_cast<T>(1 / (1 + std::exp(-x)));
+            case Activation::Tanh:    return static_cast<T>(std::tanh(x));
+            case Activation::Gelu:    return static_cast<T>(0.5 * x * std::erfc(-x * 0.70710678118654752));
+            default:                  return x;
+        }
+    }
+
+    // Bias and activation over a rows x cols block whose first column is col0
+    static void finish(T* c, size_t ldc, size_t rows, size_t cols, size_t col0, const Epilogue<T>& ep) {
+        if (!ep.active()) return;
+        const auto& kt = simd::kernels<T>();
+        const T* bias = ep.bias ? ep.bias + col0 * ep.bias_stride : nullptr;
+        for (size_t i = 0; i < rows; ++i) {
+            T* row = c + i * ldc;
+            if (bias && ep.bias_stride == 1)
+                kt.binary[size_t(OpKind::Add)](row, bias, row, cols);
+            else if (bias)
+                for (size_t j = 0; j < cols; ++j) row[j] += bias[j * ep.bias_stride];
+
+            switch (ep.act) {
+                case Activation::Relu:    kt.scalar[size_t(OpKind::Max)](row, T(), row, cols); break;
+                case Activation::Sigmoid: kt.sigmoid(row, row, cols); break;
+                case Activation::Tanh:    kt.tanh(row, row, cols); break;
+                case Activation::Gelu:    kt.gelu(row, row, cols); break;
+                default:                  break;
+            }
+        }
+    }
+
+private:
+    // ------------------------------
+    // GEMV: y[i * incy] = sum_p a(i, p) * x[p * incx], i < rows
+    // ------------------------------
+    static void gemv(size_t rows, size_t k, MatRef<T> a, const T* x, size_t incx, T* y, size_t incy) {
+        const auto& kt = simd::gemm_kernels<T>();
+        Executor& ex = Executor::global();
+
+        std::vector<T> xs;
+        if (incx != 1 && (a.cs == 1 || a.rs == 1)) {
+            xs.resize(k);
+            for (size_t p = 0; p < k; ++p) xs[p] = x[p * incx];
+            x = xs.data();
+            incx = 1;
+        }
+
+        if (a.cs == 1) {
+            // Rows contiguous: one dot product per output
+            ex.parallel_for(0, rows, std::max<size_t>(1, kChunk / k), [&](size_t lo, size_t hi) {
+                for (size_t i = lo; i < hi; ++i) y[i * incy] = kt.dot(a.p + i * a.rs, x, k);
+            }, k);
+        } else if (a.rs == 1) {
+            // Columns contiguous: y += x[p] * column p, over row chunks
+            ex.parallel_for(0, rows, 1024, [&](size_t lo, size_t hi) {
+                T acc[1024];
+                size_t len = hi - lo;
+                for (size_t r = 0; r < len; r += 1024) {
+                    size_t w = std::min<size_t>(1024, len - r);
+                    std::fill(acc, acc + w, T());
+                    for (size_t p = 0; p < k; ++p) kt.axpy(x[p], a.p + p * a.cs + lo + r, acc, w);
+                    for (size_t i = 0; i < w; ++i) y[(lo + r + i) * incy] = acc[i];
+                }
+            }, k);
+        } else {
+            ex.parallel_for(0, rows, std::max<size_t>(1, kChunk / k), [&](size_t lo, size_t hi) {
+                for (size_t i = lo; i < hi; ++i) {
+                    T s = T();
+                    for (size_t p = 0; p < k; ++p) s += a.at(i, p) * x[p * incx];
+                    y[i * incy] = s;
+                }
+            }, k);
+        }
+    }
+
+    // ------------------------------
+    // Blocked GEMM
+    // ------------------------------
+    static void blocked(size_t m, size_t n, size_t k, MatRef<T> a, MatRef<T> b,
+                        T* c, size_t ldc, const Epilogue<T>& ep) {
+        const auto& kt = simd::gemm_kernels<T>();
+        Executor& ex = Executor::global();
+        const size_t MR = kt.mr, NR = kt.nr;
+        const size_t mc = std::max(MR, kMC / MR * MR);
+        const size_t threads = ex.num_threads();
+        std::vector<T> bpack;
+
+        for (size_t jc = 0; jc < n; jc += kNC) {
+            size_t nc = std::min(kNC, n - jc);
+            size_t panels = (nc + NR - 1) / NR;
+
+            // Split columns too when there are too few row blocks to go round
+            size_t mb = (m + mc - 1) / mc;
+            size_t nb = 1;
+            if (mb < 2 * threads) nb = std::min(panels, (2 * threads + mb - 1) / mb);
+            size_t ncs = (panels + nb - 1) / nb * NR;
+            nb = (nc + ncs - 1) / ncs;
+
+            for (size_t pc = 0; pc < k; pc += kKC) {
+                size_t kc = std::min(kKC, k - pc);
+                bool acc = pc > 0, last = pc + kc == k;
+
+                bpack.resize(panels * NR * kc);
+                ex.parallel_for(0, panels, 1, [&](size_t lo, size_t hi) {
+                    for (size_t q = lo; q < hi; ++q)
+                        pack_b(b, pc, kc, jc + q * NR, std::min(NR, nc - q * NR), NR, bpack.data() + q * NR * kc);
+                }, kc * NR);
+
+                ex.parallel_for(0, mb * nb, 1, [&](size_t lo, size_t hi) {
+                    static thread_local std::vector<T> apack;
+                    alignas(64) T tile[kTile];
+                    for (size_t t = lo; t < hi; ++t) {
+                        size_t i0 = (t / nb) * mc, j0 = (t % nb) * ncs;
+                        size_t mcur = std::min(mc, m - i0), ncur = std::min(ncs, nc - j0);
+
+                        apack.resize((mcur + MR - 1) / MR * MR * kc);
+                        for (size_t ir = 0; ir < mcur; ir += MR)
+                            pack_a(a, i0 + ir, std::min(MR, mcur - ir), pc, kc, MR, apack.data() + ir * kc);
+
+                        for (size_t jr = 0; jr < ncur; jr += NR) {
+                            const T* bp = bpack.data() + (j0 + jr) * kc;
+                            size_t nr = std::min(NR, ncur - jr);
+                            for (size_t ir = 0; ir < mcur; ir += MR) {
+                                const T* ap = apack.data() + ir * kc;
+                                T* cp = c + (i0 + ir) * ldc + jc + j0 + jr;
+                                size_t mr = std::min(MR, mcur - ir);
+                                if (mr == MR && nr == NR) {
+                                    kt.micro(kc, ap, bp, cp, ldc, acc);
+                                    continue;
+                                }
+                                kt.micro(kc, ap, bp, tile, NR, false);
+                                for (size_t i = 0; i < mr; ++i)
+                                    for (size_t j = 0; j < nr; ++j)
+                                        cp[i * ldc + j] = acc ? cp[i * ldc + j] + tile[i * NR + j] : tile[i * NR + j];
+                            }
+                        }
+                        if (last) finish(c + i0 * ldc + jc + j0, ldc, mcur, ncur, jc + j0, ep);
+                    }
+                }, std::max<size_t>(1, mc * ncs * kc / 64));
+            }
+        }
+    }
+
+    // Rows [i0, i0 + mr) x cols [p0, p0 + kc) of a as dst[p * MR + i], zero padded
+    static void pack_a(MatRef<T> a, size_t i0, size_t mr, size_t p0, size_t kc, size_t MR, T* dst) {
+        if (mr == MR && a.rs == 1) {
+            for (size_t p = 0; p < kc; ++p) {
+                const T* src = a.p + i0 + (p0 + p) * a.cs;
+                std::copy(src, src + MR, dst + p * MR);
+            }
+            return;
+        }
+        for (size_t i = 0; i < MR; ++i) {
+            if (i >= mr) {
+                for (size_t p = 0; p < kc; ++p) dst[p * MR + i] = T();
+                continue;
+            }
+            const T* src = a.p + (i0 + i) * a.rs + p0 * a.cs;
+            for (size_t p = 0; p < kc; ++p) dst[p * MR + i] = src[p * a.cs];
+        }
+    }
+
+    // Rows [p0, p0 + kc) x cols [j0, j0 + nr) of b as dst[p * NR + j], zero padded
+    static void pack_b(MatRef<T> b, size_t p0, size_t kc, size_t j0, size_t nr, size_t NR, T* dst) {
+        for (size_t p = 0; p < kc; ++p, dst += NR) {
+            const T* src = b.p + (p0 + p) * b.rs + j0 * b.cs;
+            if (b.cs == 1) std::copy(src, src + nr, dst);
+            else for (size_t j = 0; j < nr; ++j) dst[j] = src[j * b.cs];
+            std::fill(dst + nr, dst + NR, T());
+        }
+    }
+
+};
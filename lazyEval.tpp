@@ -1,22 +1,58 @@
 #pragma once
 #include "Tensor.tpp"
 #include "pch.tpp"
-#include <arm_neon.h>
+#include "simd.tpp"
+#include "executor.tpp"
+#include "profiler.tpp"
+#include <memory>
+
+// ------------------------------
+// One-input math ops (OpKind::Unary)
+// ------------------------------
+enum class UnaryKind : uint8_t { Sqrt, Pow, Sin, Cos, Exp, Log, Tanh, Sigmoid, Gelu };
 
 /**
  * @brief Lazy evaluation engine for element-wise tensor operations with optional SIMD acceleration.
- * 
+ *
+ * The batch is an op graph: each op reads the running core value plus at
+ * most two operands, and an operand may itself be a pending chain (another
+ * tensor's unevaluated ops). execute() fuses the whole graph into a single
+ * pass that walks the output in cache-sized blocks, so every operand is read
+ * once and the core is written once, with kernel dispatch per block rather
+ * than per element.
+ *
  * @tparam T Data type (float, int, etc.)
- * @tparam TensorType Tensor class (contains data vector, shape, strides)
+ * @tparam TensorType Tensor storage view (shared buffer, offset, shape, strides)
  */
 template <typename T, typename TensorType>
 struct LazyEval {
+    struct Expr;
+
+    // ------------------------------
+    // Operand: a tensor view (held by value, storage is shared), or a
+    // pending chain evaluated block by block
+    // ------------------------------
+    struct Operand {
+        TensorType tensor;
+        bool has_tensor = false;
+        std::shared_ptr<const Expr> expr;
+
+        Operand() {}
+        Operand(const TensorType& t) : tensor(t), has_tensor(true) {}
+        Operand(std::shared_ptr<const Expr> e) : expr(std::move(e)) {}
+
+        bool empty() const { return !has_tensor && !expr; }
+    };
+
     // ------------------------------
     // Structure for batched operations
     // ------------------------------
     struct BatchOp {
-        std::function<T(T, T)> func;    // Element-wise operation function
-        const TensorType* tensor;       // Pointer to operand tensor
+        OpKind kind;                        // Kernel to run
+        UnaryKind unary;                    // Unary only
+        std::function<T(T, T)> func;        // Element-wise operation function (Custom only)
+        Operand b, c;                       // Operands, empty -> scalar s0/s1
+        T s0, s1;                           // Scalar operands
     };
 
     std::vector<BatchOp> batch;        // Batch of operations to execute
@@ -25,8 +61,46 @@ struct LazyEval {
     // Add an operation to the lazy batch
     // ------------------------------
     template <typename Func>
-    void add(const TensorType& other, Func f) {
-        batch.push_back({ std::function<T(T, T)>(f), &other });
+    void add(Operand other, Func f) {
+        batch.push_back({ OpKind::Custom, UnaryKind::Sqrt, std::function<T(T, T)>(f), std::move(other), {}, T(), T() });
+    }
+
+    // Known op: dispatched to the SIMD kernel for this host
+    void add(OpKind kind, Operand other) {
+        batch.push_back({ kind, UnaryKind::Sqrt, {}, std::move(other), {}, T(), T() });
+    }
+
+    // Known op with a scalar right-hand side
+    void add(OpKind kind, T s) {
+        batch.push_back({ kind, UnaryKind::Sqrt, {}, {}, {}, s, T() });
+    }
+
+    // core = core * b + c
+    void add_fma(Operand b, Operand c) {
+        batch.push_back({ OpKind::Fma, UnaryKind::Sqrt, {}, std::move(b), std::move(c), T(), T() });
+    }
+
+    // core = core * s + t
+    void add_fma(T s, T t) {
+        batch.push_back({ OpKind::Fma, UnaryKind::Sqrt, {}, {}, {}, s, t });
+    }
+
+    // core = f(core), p is the op parameter (exponent for Pow)
+    void add_unary(UnaryKind u, T p = T()) {
+        batch.push_back({ OpKind::Unary, u, {}, {}, {}, p, T() });
+    }
+
+    // ------------------------------
+    // Pending chain of another tensor, captured by value
+    // ------------------------------
+    struct Expr {
+        TensorType core;
+        std::vector<BatchOp> batch;
+    };
+
+    static Operand operand(const TensorType& core, const LazyEval& chain) {
+        if (chain.batch.empty()) return Operand(core);
+        return Operand(std::make_shared<const Expr>(Expr{ core, chain.batch }));
     }
 
     // ------------------------------
@@ -34,127 +108,310 @@ struct LazyEval {
     // ------------------------------
     void execute(TensorType& core) {
         if (batch.empty()) return;
+        if (!core.buf) { batch.clear(); return; }   // default-constructed: nothing to run on
+        ProfileScope prof("lazy.execute");
 
         // ------------------------------
         // 1. Determine target shape using broadcasting
         // ------------------------------
-        std::vector<size_t> target_shape = core.shape;
-        for (auto& op : batch)
-            target_shape = broadcast_shapes(target_shape, op.tensor->shape);
-
-        // Broadcast core tensor if necessary
-        if (core.shape != target_shape) {
-            size_t new_size = 1;
-            for (auto s : target_shape) new_size *= s;
-            std::vector<T> new_data(new_size);
-
-            std::vector<size_t> coord(target_shape.size());
-            for (size_t idx = 0; idx < new_size; ++idx) {
-                size_t tmp = idx;
-                for (int d = int(target_shape.size()) - 1; d >= 0; --d) {
-                    coord[d] = tmp % target_shape[d];
-                    tmp /= target_shape[d];
-                }
-
-                // Map coordinates back to the original tensor
-                std::vector<size_t> src_coord = coord;
-                int shift = target_shape.size() - core.shape.size();
-                for (size_t d = 0; d < core.shape.size(); ++d)
-                    if (core.shape[d] == 1) src_coord[d + shift] = 0;
-
-                size_t si = 0;
-                for (size_t d = 0; d < core.shape.size(); ++d)
-                    si += (core.shape[d] == 1 ? 0 : src_coord[d + shift]) * core.strides[d];
-
-                new_data[idx] = core.data[si];
-            }
+        std::vector<size_t> target_shape = result_shape(core.shape, batch);
+        size_t N = 1;
+        for (auto d : target_shape) N *= d;
+
+        // ------------------------------
+        // 2. Resolve operands against the output. Broadcast and strided
+        //    views are read in place, nothing is materialized
+        // ------------------------------
+        Plan plan;
+        plan.src = slot_for(core, target_shape);
+        plan.steps = resolve(batch, target_shape, N, plan);
+        if (prof.active()) {
+            size_t reads = 0, ops = 0;
+            traffic(plan, reads, ops);
+            prof.traffic(uint64_t(N) * sizeof(T) * (reads + 1), uint64_t(N) * ops);
+        }
 
-            core.data.swap(new_data);
-            core.shape = target_shape;
-            core.computeStrides();
+        // Write in place only into storage nobody else can see; copies of
+        // this tensor and captured operands keep the old values (COW)
+        TensorType result;
+        if (core.shape == target_shape && core.unique() && core.is_contiguous()) {
+            result = core;
+        } else {
+            result.shape = target_shape;
+            result.computeStrides();
+            result.buf = std::make_shared<Buffer<T>>(N);
         }
 
         // ------------------------------
-        // 2. Multithreaded execution
+        // 3. Fused execution on the shared executor
         // ------------------------------
-        static size_t threads_hardware = std::thread::hardware_concurrency();
-        if (threads_hardware == 0) threads_hardware = 4;
-
-        size_t N = core.data.size();
-        size_t min_chunk = 1024;
-        size_t chunk = std::max(N / threads_hardware, min_chunk);
-        size_t num_threads = (N + chunk - 1) / chunk;
-
-        std::atomic<size_t> next_idx(0);
-        std::vector<std::thread> threads(num_threads);
-
-        auto worker = [&](void) {
-            while (true) {
-                size_t start = next_idx.fetch_add(chunk);
-                if (start >= N) break;
-                size_t end = std::min(start + chunk, N);
-
-                // ------------------------------
-                // SIMD optimized section for float
-                // ------------------------------
-                if constexpr (std::is_same<T, float>::value) {
-                    for (auto& op : this->batch) {
-                        size_t i = start;
-                        // Vectorized loop using NEON
-                        for (; i + 4 <= end; i += 4) {
-                            float32x4_t a = vld1q_f32(&core.data[i]);
-                            float32x4_t b = vld1q_f32(&op.tensor->data[i]);
-                            float32x4_t r = vaddq_f32(a, b); // Example: addition, override with proper func if needed
-                            vst1q_f32(&core.data[i], r);
-                        }
-                        // Scalar tail
-                        for (; i < end; i++) {
-                            core.data[i] = op.func(core.data[i], op.tensor->data[i]);
-                        }
-                    }
-                }
-                // SIMD optimized section for int
-                else if constexpr (std::is_same<T, int>::value) {
-                    for (auto& op : this->batch) {
-                        size_t i = start;
-                        for (; i + 4 <= end; i += 4) {
-                            int32x4_t a = vld1q_s32(&core.data[i]);
-                            int32x4_t b = vld1q_s32(&op.tensor->data[i]);
-                            int32x4_t r = vaddq_s32(a, b);
-                            vst1q_s32(&core.data[i], r);
-                        }
-                        for (; i < end; i++) {
-                            core.data[i] = op.func(core.data[i], op.tensor->data[i]);
-                        }
-                    }
-                }
-                // Fallback for all other types
-                else {
-                    for (auto& op : this->batch) {
-                        for (size_t i = start; i < end; i++) {
-                            core.data[i] = op.func(core.data[i], op.tensor->data[i]);
-                        }
-                    }
-                }
-            }
-        };
+        Executor& ex = Executor::global();
+        size_t grain = std::max(N / (ex.num_threads() * 4), kBlock * 4);
+        grain = (grain + kBlock - 1) / kBlock * kBlock;
+        T* out = result.buf->ptr + result.offset;
 
-        // Launch threads
-        for (size_t t = 0; t < num_threads; ++t)
-            threads[t] = std::thread(worker);
+        ex.parallel_for(0, N, grain, [&](size_t start, size_t end) {
+            prof.chunk();
+            for (size_t i = start; i < end; i += kBlock)
+                eval_block(plan, i, std::min(kBlock, end - i), out + i);
+        }, plan.steps.size());
 
-        // Join threads
-        for (auto& th : threads) th.join();
+        core = std::move(result);
 
         // Clear batch after execution
         batch.clear();
     }
 
 private:
+    // Elements per fused block; operand temporaries live on the stack
+    static constexpr size_t kBlock = 256;
+    // Dims of a strided operand after merging, see Slot
+    static constexpr size_t kMaxDims = 16;
+
+    struct Plan;
+
+    // Operand resolved for one execute() call
+    struct Slot {
+        enum Mode { None, Direct, Scalar, Strided, Sub } mode = None;
+        const T* ptr = nullptr;          // Direct: row-major data of output size
+                                         // Scalar: ptr[0] broadcast
+                                         // Strided: element 0 of the view
+        std::vector<size_t> shape;       // Strided: merged output dims
+        std::vector<size_t> strides;     //          and matching view strides
+        const Plan* sub = nullptr;       // Sub: chain evaluated per block
+    };
+
+    struct Step {
+        const BatchOp* op;
+        Slot b, c;
+    };
+
+    // Flattened graph: a source for the core value and the ops applied to it
+    struct Plan {
+        Slot src;
+        std::vector<Step> steps;
+        std::vector<std::unique_ptr<Plan>> subs;      // owned sub-chains
+        std::vector<TensorType> evaluated;            // sub-chains evaluated up front
+    };
+
+    static std::vector<size_t> result_shape(std::vector<size_t> shape, const std::vector<BatchOp>& ops) {
+        for (auto& op : ops)
+            for (const Operand* o : { &op.b, &op.c }) {
+                if (o->has_tensor) shape = broadcast_shapes(shape, o->tensor.shape);
+                else if (o->expr) shape = broadcast_shapes(shape, result_shape(o->expr->core.shape, o->expr->batch));
+            }
+        return shape;
+    }
+
+    // ------------------------------
+    // How to read view t as a tensor of the output shape
+    // ------------------------------
+    static Slot slot_for(const TensorType& t, const std::vector<size_t>& shape) {
+        Slot s;
+        s.ptr = t.data();
+
+        // View strides aligned to the output, 0 on broadcast axes
+        size_t nd = shape.size(), shift = nd - t.shape.size();
+        std::vector<size_t> str(nd, 0);
+        for (size_t d = 0; d < t.shape.size(); ++d)
+            if (t.shape[d] != 1) str[d + shift] = t.strides[d];
+
+        // Merge dims that are contiguous with their neighbour, drop size-1 dims
+        std::vector<size_t> mshape, mstr;
+        for (size_t d = 0; d < nd; ++d) {
+            if (shape[d] == 1) continue;
+            if (!mshape.empty() && mstr.back() == str[d] * shape[d]) {
+                mshape.back() *= shape[d];
+                mstr.back() = str[d];
+            } else {
+                mshape.push_back(shape[d]);
+                mstr.push_back(str[d]);
+            }
+        }
+
+        if (mshape.empty() || (mshape.size() == 1 && mstr[0] == 0)) s.mode = Slot::Scalar;
+        else if (mshape.size() == 1 && mstr[0] == 1) s.mode = Slot::Direct;
+        else {
+            if (mshape.size() > kMaxDims) throw std::runtime_error("LazyEval: too many strided dims");
+            s.mode = Slot::Strided;
+            s.shape = std::move(mshape);
+            s.strides = std::move(mstr);
+        }
+        return s;
+    }
+
+    static Slot resolve_operand(const Operand& o, const std::vector<size_t>& shape, size_t N, Plan& owner) {
+        if (o.has_tensor) return slot_for(o.tensor, shape);
+        if (!o.expr) return Slot();
+
+        const Expr& e = *o.expr;
+        std::vector<size_t> sub_shape = result_shape(e.core.shape, e.batch);
+        size_t sub_n = 1;
+        for (auto d : sub_shape) sub_n *= d;
+        if (sub_n == N) {
+            // Same extent: fuse the chain into this pass
+            auto sub = std::make_unique<Plan>();
+            sub->src = slot_for(e.core, shape);
+            sub->steps = resolve(e.batch, shape, N, *sub);
+            Slot s;
+            s.mode = Slot::Sub;
+            s.sub = sub.get();
+            owner.subs.push_back(std::move(sub));
+            return s;
+        }
+
+        // Broadcast chain: evaluate once at its own shape, read it expanded
+        TensorType tmp = e.core;
+        LazyEval chain;
+        chain.batch = e.batch;
+        chain.execute(tmp);
+        owner.evaluated.push_back(std::move(tmp));
+        return slot_for(owner.evaluated.back(), shape);
+    }
+
+    static std::vector<Step> resolve(const std::vector<BatchOp>& ops, const std::vector<size_t>& shape,
+                                     size_t N, Plan& owner) {
+        std::vector<Step> steps;
+        steps.reserve(ops.size());
+        for (auto& op : ops)
+            steps.push_back({ &op, resolve_operand(op.b, shape, N, owner),
+                                   resolve_operand(op.c, shape, N, owner) });
+        return steps;
+    }
+
+    // Tensor reads per output element (plan sources and operands, sub-chains
+    // included) and element ops, for the profiler
+    static void traffic(const Plan& p, size_t& reads, size_t& ops) {
+        auto visit = [&](const Slot& s) {
+            if (s.mode == Slot::Direct || s.mode == Slot::Strided) ++reads;
+            else if (s.mode == Slot::Sub) traffic(*s.sub, reads, ops);
+        };
+        visit(p.src);
+        for (auto& step : p.steps) {
+            ++ops;
+            visit(step.b);
+            visit(step.c);
+        }
+    }
+
+    // ------------------------------
+    // Evaluate plan over [start, start + n) into out
+    // ------------------------------
+    static void eval_block(const Plan& p, size_t start, size_t n, T* out) {
+        const T* src = fetch(p.src, start, n, out);
+        if (p.src.mode == Slot::Scalar) std::fill(out, out + n, src[0]);
+        else if (src != out) std::copy(src, src + n, out);
+
+        for (auto& step : p.steps) {
+            alignas(64) T bbuf[kBlock];
+            alignas(64) T cbuf[kBlock];
+            const T* b = fetch(step.b, start, n, bbuf);
+            const T* c = fetch(step.c, start, n, cbuf);
+            apply(*step.op, step.b.mode == Slot::Scalar, step.c.mode == Slot::Scalar, b, c, out, n);
+        }
+    }
+
+    // Pointer to the block's values, gathered into buf when not contiguous
+    static const T* fetch(const Slot& s, size_t start, size_t n, T* buf) {
+        switch (s.mode) {
+            case Slot::Direct:  return s.ptr + start;
+            case Slot::Scalar:  return s.ptr;
+            case Slot::Sub:     eval_block(*s.sub, start, n, buf); return buf;
+            case Slot::Strided: gather(s, start, n, buf); return buf;
+            default:            return nullptr;
+        }
+    }
+
+    // Copy output positions [start, start + n) of a strided view, walking
+    // the inner dim contiguously. Coordinates are decoded once per block
+    static void gather(const Slot& s, size_t start, size_t n, T* out) {
+        size_t nd = s.shape.size();
+        size_t coord[kMaxDims];
+        size_t off = 0, idx = start;
+        for (size_t d = nd; d-- > 0;) {
+            coord[d] = idx % s.shape[d];
+            idx /= s.shape[d];
+            off += coord[d] * s.strides[d];
+        }
+
+        size_t inner = s.shape[nd - 1], st = s.strides[nd - 1];
+        while (n > 0) {
+            size_t take = std::min(n, inner - coord[nd - 1]);
+            const T* p = s.ptr + off;
+            if (st == 1) std::copy(p, p + take, out);
+            else if (st == 0) std::fill(out, out + take, p[0]);
+            else for (size_t i = 0; i < take; ++i) out[i] = p[i * st];
+            out += take;
+            n -= take;
+            if (n == 0) break;
+
+            // Next row: carry into the outer dims
+            off -= coord[nd - 1] * st;
+            coord[nd - 1] = 0;
+            for (size_t d = nd - 1; d-- > 0;) {
+                off += s.strides[d];
+                if (++coord[d] < s.shape[d]) break;
+                off -= s.strides[d] * s.shape[d];
+                coord[d] = 0;
+            }
+        }
+    }
+
+    // ------------------------------
+    // Apply one op to a block
+    // ------------------------------
+    static void apply(const BatchOp& op, bool b_scalar, bool c_scalar,
+                      const T* b, const T* c, T* out, size_t n) {
+        const auto& k = simd::kernels<T>();
+
+        switch (op.kind) {
+        case OpKind::Custom:
+            // Fallback for ops without a kernel
+            if (b_scalar) {
+                T v = b[0];
+                for (size_t i = 0; i < n; i++) out[i] = op.func(out[i], v);
+            } else {
+                for (size_t i = 0; i < n; i++) out[i] = op.func(out[i], b[i]);
+            }
+            break;
+        case OpKind::Unary:
+            apply_unary(op.unary, op.s0, out, n);
+            break;
+        case OpKind::Fma:
+            if (!b) k.fma_scalar(out, op.s0, op.s1, out, n);
+            else if (b_scalar && c_scalar) k.fma_scalar(out, b[0], c[0], out, n);
+            else if (b_scalar) for (size_t i = 0; i < n; i++) out[i] = out[i] * b[0] + c[i];
+            else if (c_scalar) for (size_t i = 0; i < n; i++) out[i] = out[i] * b[i] + c[0];
+            else k.fma(out, b, c, out, n);
+            break;
+        default: {
+            size_t idx = static_cast<size_t>(op.kind);
+            if (!b) k.scalar[idx](out, op.s0, out, n);
+            else if (b_scalar) k.scalar[idx](out, b[0], out, n);
+            else k.binary[idx](out, b, out, n);
+        }
+        }
+    }
+
+    static void apply_unary(UnaryKind u, T p, T* x, size_t n) {
+        const auto& k = simd::kernels<T>();
+        switch (u) {
+        case UnaryKind::Sqrt:    k.sqrt(x, x, n); break;
+        case UnaryKind::Pow:     k.pow(x, p, x, n); break;
+        case UnaryKind::Sin:     k.sin(x, x, n); break;
+        case UnaryKind::Cos:     k.cos(x, x, n); break;
+        case UnaryKind::Exp:     k.exp(x, x, n); break;
+        case UnaryKind::Log:     k.log(x, x, n); break;
+        case UnaryKind::Tanh:    k.tanh(x, x, n); break;
+        case UnaryKind::Sigmoid: k.sigmoid(x, x, n); break;
+        case UnaryKind::Gelu:    k.gelu(x, x, n); break;
+        }
+    }
+
     // ------------------------------
     // Broadcasting helper function
     // ------------------------------
-    std::vector<size_t> broadcast_shapes(const std::vector<size_t>& a, const std::vector<size_t>& b) {
+    static std::vector<size_t> broadcast_shapes(const std::vector<size_t>& a, const std::vector<size_t>& b) {
         size_t na = a.size(), nb = b.size();
         size_t n = std::max(na, nb);
         std::vector<size_t> result(n);
@@ -1,58 +1,46 @@
 #pragma once
 
 #include "pch.tpp"
-#ifdef __ARM_NEON
-#include <arm_neon.h>
-#endif
-#include <queue>
-#include <future>
-#include <condition_variable>
+#include "simd.tpp"
+#include "executor.tpp"
+#include "profiler.tpp"
 
 // =====================
-// Simple ThreadPool
+// Statistics computed by the fused pass
 // =====================
-struct ThreadPool {
-    std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
-    std::mutex queue_mutex;
-    std::condition_variable cv;
-    bool stop = false;
-
-    ThreadPool(size_t n_threads = std::thread::hardware_concurrency()) {
-        if (n_threads == 0) n_threads = 4;
-        for (size_t i = 0; i < n_threads; ++i) {
-            workers.emplace_back([this]() {
-                while (true) {
-                    std::function<void()> task;
-                    {
-                        std::unique_lock<std::mutex> lock(this->queue_mutex);
-                        this->cv.wait(lock, [this]() { return this->stop || !this->tasks.empty(); });
-                        if (this->stop && this->tasks.empty()) return;
-                        task = std::move(this->tasks.front());
-                        this->tasks.pop();
-                    }
-                    task();
-                }
-            });
-        }
-    }
+enum class StatKind : uint8_t { Sum, Mean, Min, Max, ArgMin, ArgMax, Var, Std, Len, Custom };
 
-    template<class F>
-    void enqueue(F&& f) {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            tasks.emplace(std::forward<F>(f));
-        }
-        cv.notify_one();
-    }
+// =====================
+// StatAcc: partial statistics of a run of elements
+// =====================
+template <typename T>
+struct StatAcc {
+    // Moments are kept in floating point even for integer tensors
+    using F = typename std::conditional<std::is_floating_point<T>::value, T, double>::type;
 
-    ~ThreadPool() {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            stop = true;
-        }
-        cv.notify_all();
-        for (auto &w : workers) w.join();
+    size_t count = 0;
+    T sum = T();
+    T min = T(), max = T();
+    size_t argmin = 0, argmax = 0;   // index of the first occurrence
+    F m2 = F();                      // sum of squared deviations from the mean
+
+    F mean() const { return count ? F(sum) / F(count) : F(); }
+    F var(size_t ddof = 0) const { return count > ddof ? m2 / F(count - ddof) : F(); }
+
+    // Merge two adjacent runs, a before b. Moments use Chan's update
+    static StatAcc combine(const StatAcc& a, const StatAcc& b) {
+        if (a.count == 0) return b;
+        if (b.count == 0) return a;
+        StatAcc r;
+        r.count = a.count + b.count;
+        r.sum = a.sum + b.sum;
+        F delta = b.mean() - a.mean();
+        r.m2 = a.m2 + b.m2 + delta * delta * (F(a.count) * F(b.count) / F(r.count));
+        if (b.min < a.min) { r.min = b.min; r.argmin = b.argmin; }
+        else               { r.min = a.min; r.argmin = a.argmin; }
+        if (a.max < b.max) { r.max = b.max; r.argmax = b.argmax; }
+        else               { r.max = a.max; r.argmax = a.argmax; }
+        return r;
     }
 };
 
@@ -62,71 +50,285 @@ struct ThreadPool {
 template<typename T, typename PvType>
 struct LazyEvalStat {
     using StatFunc = std::function<T(const PvType&)>;
+    using Acc = StatAcc<T>;
+
+    struct Entry {
+        StatKind kind;
+        StatFunc func;   // Custom only
+    };
 
-    std::vector<StatFunc> batch;
-    ThreadPool pool;
+    std::vector<Entry> batch;
 
-    LazyEvalStat(size_t threads = std::thread::hardware_concurrency()) : pool(threads) {}
+    // Which parts of StatAcc a batch needs
+    struct Needs {
+        bool arg = false;
+        bool m2 = false;
+    };
 
     void add(StatFunc f) {
-        batch.push_back(f);
+        batch.push_back({ StatKind::Custom, f });
+    }
+
+    void add(StatKind k) {
+        batch.push_back({ k, {} });
     }
 
     // Helper functions
-    void add_sum() {
-        add([](const PvType& core) {
-            T result = 0;
-            const auto& data = core.data;
-            size_t N = data.size();
-
-#ifdef __ARM_NEON
-            if constexpr (std::is_same<T,float>::value) {
-                size_t i=0;
-                float32x4_t acc = vdupq_n_f32(0.f);
-                for (; i+4<=N; i+=4) {
-                    float32x4_t v = vld1q_f32(&data[i]);
-                    acc = vaddq_f32(acc, v);
-                }
-                float temp[4]; vst1q_f32(temp, acc);
-                result += temp[0]+temp[1]+temp[2]+temp[3];
-                for (; i<N; i++) result += data[i];
-                return result;
-            }
-#  if defined(__aarch64__)
-            else if constexpr (std::is_same<T,double>::value) {
-                size_t i=0;
-                float64x2_t acc = vdupq_n_f64(0.0);
-                for (; i+2<=N; i+=2) {
-                    float64x2_t v = vld1q_f64(&data[i]);
-                    acc = vaddq_f64(acc, v);
-                }
-                double temp[2]; vst1q_f64(temp, acc);
-                result += temp[0]+temp[1];
-                for (; i<N; i++) result += data[i];
-                return result;
-            }
-#  endif
-#endif
-            // fallback scalar
-            for (auto v : data) result += v;
-            return result;
-        });
+    void add_sum() { add(StatKind::Sum); }
+
+    Needs needs() const {
+        Needs n;
+        for (auto& e : batch) {
+            n.arg |= e.kind == StatKind::ArgMin || e.kind == StatKind::ArgMax;
+            n.m2  |= e.kind == StatKind::Var || e.kind == StatKind::Std;
+        }
+        return n;
     }
 
-    // Execute all stats
+    // ------------------------------
+    // One fused pass over core for every built-in stat in the batch.
+    // Fixed-size chunks run in parallel and merge in a fixed tree, and
+    // each chunk sums pairwise, so results do not depend on thread count.
+    // ------------------------------
+    Acc summarize(const PvType& core) const {
+        ProfileScope prof("stat.summarize");
+        Needs need = needs();
+        PvType flat = core.contiguous();   // shares storage unless core is a strided view
+        const T* data = flat.data();
+        size_t N = flat.size();
+        prof.traffic(uint64_t(N) * sizeof(T), uint64_t(N) * batch.size());
+        return Executor::global().parallel_reduce(0, N, kChunk, Acc(),
+            [&](size_t b, size_t e) { prof.chunk(); return summarize_run(data + b, e - b, b, need); },
+            [](const Acc& a, const Acc& b) { return Acc::combine(a, b); });
+    }
+
+    // Execute all stats, values in the order they were added
     std::vector<T> execute(const PvType& core, bool clear_after=true) {
-        std::vector<std::future<void>> futures;
         std::vector<T> results(batch.size());
 
-        for (size_t i = 0; i < batch.size(); ++i) {
-            futures.push_back(std::async(std::launch::async, [&, i]() {
-                results[i] = batch[i](core);
-            }));
-        }
+        bool fused = false;
+        for (auto& e : batch) fused |= e.kind != StatKind::Custom;
+        Acc acc;
+        if (fused) acc = summarize(core);
 
-        for (auto &f : futures) f.wait();
+        Executor::global().parallel_for(0, batch.size(), 1, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i)
+                results[i] = batch[i].kind == StatKind::Custom ? batch[i].func(core)
+                                                               : value(acc, batch[i].kind);
+        }, core.size());
 
         if (clear_after) batch.clear();
         return results;
     }
+
+    static T value(const Acc& acc, StatKind k, size_t ddof = 0) {
+        switch (k) {
+            case StatKind::Sum:    return acc.sum;
+            case StatKind::Mean:   return mean_of(acc);
+            case StatKind::Min:    return acc.min;
+            case StatKind::Max:    return acc.max;
+            case StatKind::ArgMin: return static_cast<T>(acc.argmin);
+            case StatKind::ArgMax: return static_cast<T>(acc.argmax);
+            case StatKind::Var:    return static_cast<T>(acc.var(ddof));
+            case StatKind::Std:    return static_cast<T>(std::sqrt(acc.var(ddof)));
+            case StatKind::Len:    return static_cast<T>(acc.count);
+            default:               return T();
+        }
+    }
+
+    // Integer means keep integer division, as before
+    static T mean_of(const Acc& acc) {
+        if (acc.count == 0) return T();
+        if constexpr (std::is_integral<T>::value) return acc.sum / static_cast<T>(acc.count);
+        else return static_cast<T>(acc.mean());
+    }
+
+    // ------------------------------
+    // Statistics of a contiguous run; index_base is the index of p[0]
+    // ------------------------------
+    static Acc summarize_run(const T* p, size_t n, size_t index_base, const Needs& need) {
+        if (n > kLeaf) {
+            // Pairwise: split at a leaf boundary so chunking stays deterministic
+            size_t half = (n / 2 + kLeaf - 1) / kLeaf * kLeaf;
+            return Acc::combine(summarize_run(p, half, index_base, need),
+                                summarize_run(p + half, n - half, index_base + half, need));
+        }
+
+        Acc acc;
+        if (n == 0) return acc;
+        const auto& k = simd::kernels<T>();
+        T out[3];
+        k.summary(p, n, out);
+        acc.count = n;
+        acc.sum = out[0];
+        acc.min = out[1];
+        acc.max = out[2];
+
+        if (need.arg) {
+            // Leaf is cache-hot, find the first occurrences
+            acc.argmin = acc.argmax = index_base;
+            bool got_min = false, got_max = false;
+            for (size_t i = 0; i < n && !(got_min && got_max); ++i) {
+                if (!got_min && p[i] == acc.min) { acc.argmin = index_base + i; got_min = true; }
+                if (!got_max && p[i] == acc.max) { acc.argmax = index_base + i; got_max = true; }
+            }
+        }
+        if (need.m2) {
+            typename Acc::F m = acc.mean();
+            if constexpr (std::is_floating_point<T>::value) {
+                acc.m2 = k.sqdev(p, n, m);
+            } else {
+                for (size_t i = 0; i < n; ++i) {
+                    typename Acc::F d = typename Acc::F(p[i]) - m;
+                    acc.m2 += d * d;
+                }
+            }
+        }
+        return acc;
+    }
+
+    // ------------------------------
+    // Reduce the given axes of core. One Acc per output element, in
+    // row-major order of the kept axes. Arg indices are flat indices into
+    // the reduced axes (the coordinate itself for a single axis).
+    // ------------------------------
+    static std::vector<Acc> reduce_axes(const PvType& core, std::vector<size_t> axes, const Needs& need) {
+        size_t nd = core.shape.size();
+        std::vector<bool> reduced(nd, false);
+        for (auto a : axes) {
+            if (a >= nd) throw std::runtime_error("reduce: axis out of range");
+            reduced[a] = true;
+        }
+
+        std::vector<size_t> kext, kstr, rext, rstr;
+        for (size_t d = 0; d < nd; ++d) {
+            if (reduced[d]) { rext.push_back(core.shape[d]); rstr.push_back(core.strides[d]); }
+            else            { kext.push_back(core.shape[d]); kstr.push_back(core.strides[d]); }
+        }
+        size_t M = 1, L = 1;
+        for (auto e : kext) M *= e;
+        for (auto e : rext) L *= e;
+        std::vector<Acc> out(M);
+        if (M == 0 || L == 0) return out;
+        ProfileScope prof("stat.reduce_axes");
+        prof.traffic(uint64_t(M) * L * sizeof(T), uint64_t(M) * L);
+
+        const T* data = core.data();
+        Executor& ex = Executor::global();
+
+        if (!kext.empty() && kstr.back() == 1 && (rext.empty() || rstr.back() != 1)) {
+            // ------------------------------
+            // Inner axis kept: reduce whole rows element-wise
+            // ------------------------------
+            size_t Lk = kext.back();
+            size_t groups = M / Lk;
+            kext.pop_back(); kstr.pop_back();
+            ex.parallel_for(0, groups, 1, [&](size_t gb, size_t ge) {
+                prof.chunk();
+                for (size_t g = gb; g < ge; ++g)
+                    reduce_rows(data + offset_of(g, kext, kstr), Lk, rext, rstr, L, need, &out[g * Lk]);
+            }, L * Lk);
+            return out;
+        }
+
+        // ------------------------------
+        // Inner axis reduced: merge contiguous trailing reduced axes into
+        // one run and summarize runs with the fused kernel
+        // ------------------------------
+        size_t run = 1;
+        while (!rext.empty() && rstr.back() == run) {
+            run *= rext.back();
+            rext.pop_back(); rstr.pop_back();
+        }
+        size_t outer = L / run;
+        if (outer == 1 && M < ex.num_threads()) {
+            // Few long rows: split each row across the pool instead
+            for (size_t o = 0; o < M; ++o) {
+                const T* base = data + offset_of(o, kext, kstr);
+                out[o] = ex.parallel_reduce(0, run, kChunk, Acc(),
+                    [&](size_t b, size_t e) { prof.chunk(); return summarize_run(base + b, e - b, b, need); },
+                    [](const Acc& a, const Acc& b) { return Acc::combine(a, b); });
+            }
+            return out;
+        }
+        ex.parallel_for(0, M, std::max<size_t>(1, kChunk / L), [&](size_t ob, size_t oe) {
+            prof.chunk();
+            for (size_t o = ob; o < oe; ++o) {
+                const T* base = data + offset_of(o, kext, kstr);
+                Acc acc;
+                for (size_t r = 0; r < outer; ++r)
+                    acc = Acc::combine(acc, summarize_run(base + offset_of(r, rext, rstr), run, r * run, need));
+                out[o] = acc;
+            }
+        }, L);
+        return out;
+    }
+
+private:
+    static constexpr size_t kChunk = 16384;  // elements per parallel chunk
+    static constexpr size_t kLeaf = 256;     // pairwise leaf, one kernel call
+
+    // Memory offset of the i-th row-major coordinate over (ext, str)
+    static size_t offset_of(size_t i, const std::vector<size_t>& ext, const std::vector<size_t>& str) {
+        size_t off = 0;
+        for (size_t d = ext.size(); d-- > 0;) {
+            off += (i % ext[d]) * str[d];
+            i /= ext[d];
+        }
+        return off;
+    }
+
+    // Reduce L rows of Lk contiguous elements (row r at base + offset_of(r))
+    // into Lk accumulators. Sums use Kahan compensation per column.
+    static void reduce_rows(const T* base, size_t Lk, const std::vector<size_t>& rext,
+                            const std::vector<size_t>& rstr, size_t L, const Needs& need, Acc* out) {
+        const auto& k = simd::kernels<T>();
+        std::vector<T> sum(base, base + Lk), mn(sum), mx(sum), comp(Lk, T());
+        std::vector<size_t> amin(Lk, 0), amax(Lk, 0);
+
+        for (size_t r = 1; r < L; ++r) {
+            const T* row = base + offset_of(r, rext, rstr);
+            if constexpr (std::is_floating_point<T>::value) {
+                for (size_t j = 0; j < Lk; ++j) {
+                    T y = row[j] - comp[j];
+                    T t = sum[j] + y;
+                    comp[j] = (t - sum[j]) - y;
+                    sum[j] = t;
+                }
+            } else {
+                k.binary[size_t(OpKind::Add)](sum.data(), row, sum.data(), Lk);
+            }
+            if (need.arg) {
+                for (size_t j = 0; j < Lk; ++j) {
+                    if (row[j] < mn[j]) { mn[j] = row[j]; amin[j] = r; }
+                    if (mx[j] < row[j]) { mx[j] = row[j]; amax[j] = r; }
+                }
+            } else {
+                k.binary[size_t(OpKind::Min)](mn.data(), row, mn.data(), Lk);
+                k.binary[size_t(OpKind::Max)](mx.data(), row, mx.data(), Lk);
+            }
+        }
+
+        for (size_t j = 0; j < Lk; ++j) {
+            out[j].count = L;
+            out[j].sum = sum[j];
+            out[j].min = mn[j];  out[j].argmin = amin[j];
+            out[j].max = mx[j];  out[j].argmax = amax[j];
+        }
+
+        if (need.m2) {
+            // Second pass against the now known means
+            using F = typename Acc::F;
+            std::vector<F> mean(Lk), m2(Lk, F());
+            for (size_t j = 0; j < Lk; ++j) mean[j] = out[j].mean();
+            for (size_t r = 0; r < L; ++r) {
+                const T* row = base + offset_of(r, rext, rstr);
+                for (size_t j = 0; j < Lk; ++j) {
+                    F d = F(row[j]) - mean[j];
+                    m2[j] += d * d;
+                }
+            }
+            for (size_t j = 0; j < Lk; ++j) out[j].m2 = m2[j];
+        }
+    }
 };
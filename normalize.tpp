@@ -0,0 +1,190 @@
+#pragma once
+
+#include "Tensor.tpp"
+#include "simd.tpp"
+#include "executor.tpp"
+#include "profiler.tpp"
+
+/* Softmax, log-softmax, layer norm and RMS norm along one axis.
+   Every kind takes one statistics sweep and one normalize sweep. Softmax
+   statistics are an online max with the running sum of exponentials
+   rescaled whenever a block raises it; the SIMD kernels keep the softmax
+   exponentials of the statistics sweep and the normalize sweep rescales
+   them per block, so each element is exponentiated once. Layer norm keeps
+   a Welford mean and M2 (per block of a row, merged; per tile row across
+   a tile), RMS norm a sum of squares. A block is re-read while it sits in
+   L1, never from memory. The last axis runs the row kernels of
+   simd::kernels; any other axis is processed as n x kCols tiles whose
+   rows are contiguous, so the same SIMD kernels stream them. */
+
+enum class NormKind : uint8_t { Softmax, LogSoftmax, LayerNorm, RmsNorm };
+
+template <typename T>
+struct Normalize {
+    static constexpr size_t kCols = 256;     // tile width when the axis is not last
+    static constexpr size_t kChunk = 16384;  // elements per parallel piece
+    static constexpr size_t kRowBlock = 16;  // tile rows per statistics block
+
+    static const char* name(NormKind k) {
+        switch (k) {
+            case NormKind::Softmax:    return "norm.softmax";
+            case NormKind::LogSoftmax: return "norm.log_softmax";
+            case NormKind::LayerNorm:  return "norm.layernorm";
+            default:                   return "norm.rmsnorm";
+        }
+    }
+
+    // gamma, beta: empty, or 1-D with a.shape[axis] elements
+    static Pv<T> run(const Pv<T>& a, size_t axis, NormKind kind, T eps = T(),
+                     const Pv<T>& gamma = Pv<T>(), const Pv<T>& beta = Pv<T>()) {
+        static_assert(std::is_floating_point<T>::value, "normalization needs a floating-point tensor");
+        if (axis >= a.shape.size()) throw std::runtime_error("normalize: axis out of range");
+        size_t n = a.shape[axis];
+        Pv<T> g = param(gamma, n, "gamma"), b = param(beta, n, "beta");
+
+        Pv<T> out;
+        out.shape = a.shape;
+        out.computeStrides();
+        out.buf = std::make_shared<Buffer<T>>(out.count());
+        size_t N = out.count();
+        if (N == 0) return out;
+
+        size_t outer = 1, inner = 1;
+        for (size_t d = 0; d < axis; ++d) outer *= a.shape[d];
+        for (size_t d = axis + 1; d < a.shape.size(); ++d) inner *= a.shape[d];
+
+        ProfileScope prof(name(kind));
+        prof.traffic(uint64_t(N) * sizeof(T) * 2, uint64_t(N) * 6);
+
+        Pv<T> x = a.contiguous();
+        const auto& k = simd::kernels<T>();
+        const T* src = x.data();
+        T* dst = out.buf->ptr;
+        const T* gp = g.size() ? g.data() : nullptr;
+        const T* bp = b.size() ? b.data() : nullptr;
+        Executor& ex = Executor::global();
+
+        if (inner == 1) {
+            ex.parallel_for(0, outer, std::max<size_t>(1, kChunk / n), [&](size_t lo, size_t hi) {
+                prof.chunk();
+                for (size_t r = lo; r < hi; ++r)
+                    row(k, kind, src + r * n, dst + r * n, n, eps, gp, bp);
+            }, n);
+            return out;
+        }
+
+        size_t nb = (inner + kCols - 1) / kCols;
+        ex.parallel_for(0, outer * nb, std::max<size_t>(1, kChunk / (n * kCols)), [&](size_t lo, size_t hi) {
+            prof.chunk();
+            std::vector<T> scratch((4 + (kind == NormKind::Softmax ? blocks(n) : 0)) * kCols);
+            for (size_t t = lo; t < hi; ++t) {
+                size_t c0 = (t % nb) * kCols;
+                size_t base = (t / nb) * n * inner + c0;
+                tile(k, kind, src + base, dst + base, n, inner, std::min(kCols, inner - c0),
+                     eps, gp, bp, scratch.data());
+            }
+        }, n * kCols);
+        return out;
+    }
+
+private:
+    static Pv<T> param(const Pv<T>& p, size_t n, const char* what) {
+        if (p.size() == 0) return p;
+        if (p.shape.size() != 1 || p.shape[0] != n)
+            throw std::runtime_error(std::string("normalize: ") + what + " must be 1-D with the axis length");
+        return p.contiguous();
+    }
+
+    static void row(const simd::KernelTable<T>& k, NormKind kind, const T* x, T* y, size_t n,
+                    T eps, const T* gamma, const T* beta) {
+        switch (kind) {
+            case NormKind::Softmax:    k.softmax(x, y, n); break;
+            case NormKind::LogSoftmax: k.log_softmax(x, y, n); break;
+            case NormKind::LayerNorm:  k.layernorm(x, y, n, eps, gamma, beta); break;
+            case NormKind::RmsNorm:    k.rmsnorm(x, y, n, eps, gamma, nullptr); break;
+        }
+    }
+
+    static size_t blocks(size_t n) { return (n + kRowBlock - 1) / kRowBlock; }
+
+    // ------------------------------
+    // n rows of w columns, row stride ld; s holds 4 * kCols scratch, plus
+    // blocks(n) * kCols for softmax
+    // ------------------------------
+    static void tile(const simd::KernelTable<T>& k, NormKind kind, const T* x, T* y,
+                     size_t n, size_t ld, size_t w, T eps, const T* gamma, const T* beta, T* s) {
+        const auto Add = size_t(OpKind::Add), Sub = size_t(OpKind::Sub), Mul = size_t(OpKind::Mul),
+                   Max = size_t(OpKind::Max);
+        T* a = s;              // running max, or mean
+        T* b = s + kCols;      // running sum of exponentials, or of squared deviations
+        T* t = s + 2 * kCols;  // two rows of temporaries
+        T* u = s + 3 * kCols;
+        T* bm = s + 4 * kCols; // softmax: the max each block was exponentiated against
+
+        if (kind == NormKind::Softmax || kind == NormKind::LogSoftmax) {
+            bool store = kind == NormKind::Softmax;
+            std::fill(a, a + w, std::numeric_limits<T>::lowest());
+            std::fill(b, b + w, T());
+            for (size_t i0 = 0; i0 < n; i0 += kRowBlock) {
+                size_t i1 = std::min(n, i0 + kRowBlock);
+                T* m = store ? bm + (i0 / kRowBlock) * kCols : t;
+                k.binary[Max](a, x + i0 * ld, m, w);
+                for (size_t i = i0 + 1; i < i1; ++i) k.binary[Max](m, x + i * ld, m, w);
+                k.binary[Sub](a, m, u, w);   // b *= e^(old max - new max)
+                k.exp(u, u, w);
+                k.binary[Mul](b, u, b, w);
+                std::copy(m, m + w, a);
+                for (size_t i = i0; i < i1; ++i) {
+                    T* e = store ? y + i * ld : t;
+                    k.binary[Sub](x + i * ld, a, e, w);
+                    k.exp(e, e, w);
+                    k.binary[Add](b, e, b, w);
+                }
+            }
+            if (!store) {
+                k.log(b, b, w);
+                k.binary[Add](a, b, a, w);
+                for (size_t i = 0; i < n; ++i) k.binary[Sub](x + i * ld, a, y + i * ld, w);
+                return;
+            }
+            for (size_t j = 0; j < w; ++j) b[j] = T(1) / b[j];
+            for (size_t i0 = 0; i0 < n; i0 += kRowBlock) {
+                size_t i1 = std::min(n, i0 + kRowBlock);
+                k.binary[Sub](bm + (i0 / kRowBlock) * kCols, a, u, w);
+                k.exp(u, u, w);
+                k.binary[Mul](u, b, u, w);
+                for (size_t i = i0; i < i1; ++i) k.binary[Mul](y + i * ld, u, y + i * ld, w);
+            }
+            return;
+        }
+
+        bool center = kind == NormKind::LayerNorm;
+        std::fill(a, a + w, T());
+        std::fill(b, b + w, T());
+        for (size_t i = 0; i < n; ++i) {
+            const T* xi = x + i * ld;
+            if (center) {
+                // Welford: t = x - mean, mean += t / (i + 1), m2 += t * (x - mean)
+                k.binary[Sub](xi, a, t, w);
+                k.fma_scalar(t, T(1) / T(i + 1), T(), u, w);
+                k.binary[Add](a, u, a, w);
+                k.binary[Sub](xi, a, u, w);
+                k.fma(t, u, b, b, w);
+            } else {
+                k.fma(xi, xi, b, b, w);
+            }
+        }
+        for (size_t j = 0; j < w; ++j) b[j] = T(1) / std::sqrt(b[j] / T(n) + eps);
+        for (size_t i = 0; i < n; ++i) {
+            T* yi = y + i * ld;
+            if (center) {
+                k.binary[Sub](x + i * ld, a, yi, w);
+                k.binary[Mul](yi, b, yi, w);
+            } else {
+                k.binary[Mul](x + i * ld, b, yi, w);
+            }
+            if (gamma || beta)
+                k.fma_scalar(yi, gamma ? gamma[i] : T(1), beta && center ? beta[i] : T(), yi, w);
+        }
+    }
+};
@@ -0,0 +1,233 @@
+#pragma once
+
+#include "pch.tpp"
+#include "executor.tpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+/* Opt-in op profiler.
+   When enabled (Profiler::global().enable(), or FT_PROFILE=1), the lazy
+   engines record one event per op: wall time, bytes moved, flops, the
+   number of parallel chunks and how many threads ran them. Disabled, each
+   op pays one relaxed atomic load. Events can be summarized per op or
+   exported as Chrome trace JSON (chrome://tracing, Perfetto). */
+
+// =====================
+// ProfileEvent
+// =====================
+struct ProfileEvent {
+    std::string name;
+    uint64_t start_ns = 0;   // since the profiler epoch
+    uint64_t dur_ns = 0;
+    uint64_t bytes = 0;      // read + written
+    uint64_t flops = 0;      // element ops, one per op per element
+    size_t threads = 0;      // distinct threads that ran a chunk
+    size_t chunks = 0;       // pieces handed out by the executor
+    uint32_t tid = 0;        // calling thread, small sequential id
+    uint32_t depth = 0;      // nesting level on the calling thread
+};
+
+// =====================
+// Profiler
+// =====================
+class Profiler {
+public:
+    static constexpr size_t kMaxEvents = size_t(1) << 20;
+
+    static Profiler& global() {
+        static Profiler p;
+        return p;
+    }
+
+    void enable(bool on = true) { on_.store(on, std::memory_order_relaxed); }
+    void disable() { enable(false); }
+    bool enabled() const { return on_.load(std::memory_order_relaxed); }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        log.clear();
+        dropped_ = 0;
+    }
+
+    // Events beyond kMaxEvents are counted, not stored
+    size_t dropped() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return dropped_;
+    }
+
+    std::vector<ProfileEvent> events() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return log;
+    }
+
+    void record(ProfileEvent e) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (log.size() < kMaxEvents) log.push_back(std::move(e));
+        else ++dropped_;
+    }
+
+    uint64_t now_ns() const {
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch).count());
+    }
+
+    // ------------------------------
+    // Totals per op name
+    // ------------------------------
+    struct Totals {
+        size_t count = 0;
+        uint64_t ns = 0, bytes = 0, flops = 0;
+        size_t max_threads = 0, chunks = 0;
+
+        double gbps() const { return ns ? double(bytes) / double(ns) : 0.0; }
+        double gflops() const { return ns ? double(flops) / double(ns) : 0.0; }
+    };
+
+    std::map<std::string, Totals> totals() const {
+        std::map<std::string, Totals> r;
+        for (auto& e : events()) {
+            Totals& t = r[e.name];
+            ++t.count;
+            t.ns += e.dur_ns;
+            t.bytes += e.bytes;
+            t.flops += e.flops;
+            t.chunks += e.chunks;
+            t.max_threads = std::max(t.max_threads, e.threads);
+        }
+        return r;
+    }
+
+    void report(std::ostream& os = std::cout) const {
+        char line[160];
+        std::snprintf(line, sizeof line, "%-22s %8s %12s %10s %10s %8s %8s\n",
+                      "op", "calls", "total ms", "GB/s", "GFLOP/s", "threads", "chunks");
+        os << line;
+        for (auto& kv : totals()) {
+            const Totals& t = kv.second;
+            std::snprintf(line, sizeof line, "%-22s %8zu %12.3f %10.2f %10.2f %8zu %8zu\n",
+                          kv.first.c_str(), t.count, double(t.ns) / 1e6, t.gbps(), t.gflops(),
+                          t.max_threads, t.chunks);
+            os << line;
+        }
+    }
+
+    // ------------------------------
+    // Chrome trace: complete ("X") events, timestamps in microseconds
+    // ------------------------------
+    std::string chrome_trace() const {
+        std::ostringstream os;
+        os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        for (auto& e : events()) {
+            if (!first) os << ',';
+            first = false;
+            char buf[384];
+            std::snprintf(buf, sizeof buf,
+                "{\"name\":\"%s\",\"cat\":\"fasttensor\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"bytes\":%llu,\"flops\":%llu,"
+                "\"threads\":%zu,\"chunks\":%zu,\"GB/s\":%.3f}}",
+                escape(e.name).c_str(), e.tid, double(e.start_ns) / 1e3, double(e.dur_ns) / 1e3,
+                (unsigned long long)e.bytes, (unsigned long long)e.flops, e.threads, e.chunks,
+                e.dur_ns ? double(e.bytes) / double(e.dur_ns) : 0.0);
+            os << buf;
+        }
+        os << "]}\n";
+        return os.str();
+    }
+
+    void write_chrome_trace(const std::string& path) const {
+        std::ofstream f(path);
+        if (!f) throw std::runtime_error("profiler: cannot write " + path);
+        f << chrome_trace();
+    }
+
+    static uint32_t thread_id() {
+        static std::atomic<uint32_t> next{1};
+        static thread_local uint32_t id = next.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+
+    static uint32_t& depth() {
+        static thread_local uint32_t d = 0;
+        return d;
+    }
+
+private:
+    std::atomic<bool> on_{false};
+    mutable std::mutex mutex;
+    std::vector<ProfileEvent> log;
+    size_t dropped_ = 0;
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    Profiler() {
+        if (const char* env = std::getenv("FT_PROFILE")) on_.store(std::strcmp(env, "0") != 0);
+    }
+
+    static std::string escape(const std::string& s) {
+        std::string r;
+        for (char c : s) {
+            if (c == '"' || c == '\\') r += '\\';
+            if (static_cast<unsigned char>(c) >= 0x20) r += c;
+        }
+        return r;
+    }
+};
+
+// =====================
+// ProfileScope: one event from construction to destruction. Inert (no
+// clock reads, no counting) unless the profiler was on at construction.
+// chunk() is called from inside parallel bodies.
+// =====================
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) : on(Profiler::global().enabled()) {
+        if (!on) return;
+        ev.name = name;
+        ev.tid = Profiler::thread_id();
+        ev.depth = Profiler::depth()++;
+        ev.start_ns = Profiler::global().now_ns();
+    }
+
+    ~ProfileScope() {
+        if (!on) return;
+        Profiler& p = Profiler::global();
+        ev.dur_ns = p.now_ns() - ev.start_ns;
+        ev.chunks = chunk_count.load(std::memory_order_relaxed);
+        uint64_t m = thread_mask.load(std::memory_order_relaxed);
+        ev.threads = 0;
+        for (; m; m &= m - 1) ++ev.threads;
+        --Profiler::depth();
+        p.record(std::move(ev));
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    bool active() const { return on; }
+
+    void traffic(uint64_t bytes, uint64_t flops) {
+        if (!on) return;
+        ev.bytes = bytes;
+        ev.flops = flops;
+    }
+
+    void chunk() {
+        if (!on) return;
+        chunk_count.fetch_add(1, std::memory_order_relaxed);
+        size_t w = Executor::global().current_worker();
+        uint64_t bit = uint64_t(1) << (w == Executor::npos ? 63 : std::min<size_t>(w, 62));
+        thread_mask.fetch_or(bit, std::memory_order_relaxed);
+    }
+
+private:
+    bool on;
+    ProfileEvent ev;
+    std::atomic<size_t> chunk_count{0};
+    std::atomic<uint64_t> thread_mask{0};
+};
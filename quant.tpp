@@ -0,0 +1,960 @@
+#pragma once
+
+#include "TensorOps.tpp"
+#include <cstring>
+#include <limits>
+
+/* Quantized storage.
+   int8 / uint8 tensors carry a scale and zero-point, either one pair for
+   the whole tensor or one per index of a channel axis:
+       real = scale * (q - zero_point)
+   fp16 tensors store IEEE half and compute in fp32. Products accumulate
+   exactly in int32 (VNNI dpbusd, AVX2 madd, NEON SDOT / smull) and are
+   rescaled to float once per output. */
+
+// IEEE 754 binary16, storage only
+struct Half {
+    uint16_t bits = 0;
+};
+
+// =====================
+// QParams
+// =====================
+struct QParams {
+    std::vector<float> scale{ 1.f };
+    std::vector<int32_t> zero_point{ 0 };
+    size_t axis = 0;   // channel axis, used when there is more than one pair
+
+    bool per_channel() const { return scale.size() > 1; }
+};
+
+namespace simd {
+
+// ------------------------------
+// Scalar reference, also used for vector tails
+// ------------------------------
+template <typename Q>
+inline Q quantize_one(float x, float inv_scale, int32_t zp) {
+    const float lo = float(std::numeric_limits<Q>::min()), hi = float(std::numeric_limits<Q>::max());
+    float r = std::nearbyint(x * inv_scale) + float(zp);
+    r = r < hi ? r : hi;   // NaN -> hi, the vector kernels match
+    r = r > lo ? r : lo;
+    return static_cast<Q>(r);
+}
+
+inline uint16_t half_from_float(float f) {
+    uint32_t x;
+    std::memcpy(&x, &f, 4);
+    uint32_t sign = (x >> 16) & 0x8000, mant = x & 0x7fffff;
+    int32_t exp = int32_t((x >> 23) & 0xff);
+    if (exp == 0xff) return uint16_t(sign | 0x7c00 | (mant ? 0x200 | (mant >> 13) : 0));
+    int32_t e = exp - 127 + 15;
+    if (e >= 0x1f) return uint16_t(sign | 0x7c00);
+    if (e <= 0) {
+        // Subnormal half, round to nearest even
+        if (e < -10) return uint16_t(sign);
+        mant |= 0x800000;
+        uint32_t shift = uint32_t(14 - e);
+        uint32_t h = mant >> shift, rem = mant & ((1u << shift) - 1), mid = 1u << (shift - 1);
+        if (rem > mid || (rem == mid && (h & 1))) ++h;
+        return uint16_t(sign | h);
+    }
+    uint32_t h = (uint32_t(e) << 10) | (mant >> 13), rem = mant & 0x1fff;
+    if (rem > 0x1000 || (rem == 0x1000 && (h & 1))) ++h;   // may carry into inf
+    return uint16_t(sign | h);
+}
+
+inline float half_to_float(uint16_t h) {
+    uint32_t sign = uint32_t(h & 0x8000) << 16, exp = (h >> 10) & 0x1f, mant = h & 0x3ff, x;
+    if (exp == 0x1f) x = sign | 0x7f800000 | (mant << 13);
+    else if (exp) x = sign | ((exp + 112) << 23) | (mant << 13);
+    else if (!mant) x = sign;
+    else {
+        int32_t e = -1;
+        do { ++e; mant <<= 1; } while (!(mant & 0x400));
+        x = sign | (uint32_t(112 - e) << 23) | ((mant & 0x3ff) << 13);
+    }
+    float f;
+    std::memcpy(&f, &x, 4);
+    return f;
+}
+
+struct ScalarQ {
+    template <typename Q>
+    static void quantize(const float* x, size_t n, float inv_scale, int32_t zp, Q* out) {
+        for (size_t i = 0; i < n; ++i) out[i] = quantize_one<Q>(x[i], inv_scale, zp);
+    }
+    template <typename Q>
+    static void dequantize(const Q* q, size_t n, float scale, int32_t zp, float* out) {
+        for (size_t i = 0; i < n; ++i) out[i] = float(int32_t(q[i]) - zp) * scale;
+    }
+    static int32_t dot(const int8_t* a, const int8_t* b, size_t n) {
+        int32_t s = 0;
+        for (size_t i = 0; i < n; ++i) s += int32_t(a[i]) * int32_t(b[i]);
+        return s;
+    }
+    static void dot4(const int8_t* a, const int8_t* b, size_t ldb, size_t n, int32_t* out) {
+        for (size_t j = 0; j < 4; ++j) out[j] = dot(a, b + j * ldb, n);
+    }
+    static constexpr size_t kRows = 1;
+    static void tile(const int8_t* a, size_t, const int8_t* b, size_t ldb, size_t n, int32_t* out, size_t) {
+        dot4(a, b, ldb, n, out);
+    }
+    static float dot_half(const float* x, const uint16_t* h, size_t n) {
+        float s = 0.f;
+        for (size_t i = 0; i < n; ++i) s += x[i] * half_to_float(h[i]);
+        return s;
+    }
+    static void to_float(const uint16_t* h, float* out, size_t n) {
+        for (size_t i = 0; i < n; ++i) out[i] = half_to_float(h[i]);
+    }
+    static void to_half(const float* x, uint16_t* out, size_t n) {
+        for (size_t i = 0; i < n; ++i) out[i] = half_from_float(x[i]);
+    }
+};
+
+#ifdef FT_ARCH_X86
+#define FT_F16C     FT_TARGET("avx2,fma,f16c")
+#define FT_AVXVNNI  FT_TARGET("avx2,avxvnni")
+#define FT_VNNI512  FT_TARGET("avx2,avx512f,avx512vl,avx512vnni")
+
+FT_AVX2 inline int32_t hsum_epi32(__m256i v) {
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4e));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xb1));
+    return _mm_cvtsi128_si32(s);
+}
+
+// ------------------------------
+// AVX2: conversions, and an exact int8 dot through sign-extended
+// madd_epi16 (maddubs saturates in int16 for full-range int8)
+// ------------------------------
+struct Avx2Q {
+    FT_AVX2 static __m256i round8(const float* x, __m256 inv, __m256 zp, __m256 lo, __m256 hi) {
+        __m256 r = _mm256_round_ps(_mm256_mul_ps(_mm256_loadu_ps(x), inv),
+                                   _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        r = _mm256_max_ps(_mm256_min_ps(_mm256_add_ps(r, zp), hi), lo);
+        return _mm256_cvtps_epi32(r);
+    }
+
+    template <typename Q>
+    FT_AVX2 static void quantize(const float* x, size_t n, float inv_scale, int32_t zp, Q* out) {
+        constexpr bool sgn = std::is_signed<Q>::value;
+        const __m256 vi = _mm256_set1_ps(inv_scale), vz = _mm256_set1_ps(float(zp));
+        const __m256 lo = _mm256_set1_ps(float(std::numeric_limits<Q>::min()));
+        const __m256 hi = _mm256_set1_ps(float(std::numeric_limits<Q>::max()));
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            __m256i p01 = _mm256_packs_epi32(round8(x + i, vi, vz, lo, hi), round8(x + i + 8, vi, vz, lo, hi));
+            __m256i p23 = _mm256_packs_epi32(round8(x + i + 16, vi, vz, lo, hi), round8(x + i + 24, vi, vz, lo, hi));
+            __m256i b = sgn ? _mm256_packs_epi16(p01, p23) : _mm256_packus_epi16(p01, p23);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_permutevar8x32_epi32(b, order));
+        }
+        for (; i < n; ++i) out[i] = quantize_one<Q>(x[i], inv_scale, zp);
+    }
+
+    template <typename Q>
+    FT_AVX2 static void dequantize(const Q* q, size_t n, float scale, int32_t zp, float* out) {
+        const __m256 vs = _mm256_set1_ps(scale);
+        const __m256i vz = _mm256_set1_epi32(zp);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(q + i));
+            __m256i v = std::is_signed<Q>::value ? _mm256_cvtepi8_epi32(b) : _mm256_cvtepu8_epi32(b);
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(v, vz)), vs));
+        }
+        for (; i < n; ++i) out[i] = float(int32_t(q[i]) - zp) * scale;
+    }
+
+    FT_AVX2 static __m256i widen(const int8_t* p) {
+        return _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+
+    FT_AVX2 static int32_t dot(const int8_t* a, const int8_t* b, size_t n) {
+        __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(widen(a + i), widen(b + i)));
+            acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(widen(a + i + 16), widen(b + i + 16)));
+        }
+        int32_t s = hsum_epi32(_mm256_add_epi32(acc0, acc1));
+        for (; i < n; ++i) s += int32_t(a[i]) * int32_t(b[i]);
+        return s;
+    }
+
+    FT_AVX2 static void dot4(const int8_t* a, const int8_t* b, size_t ldb, size_t n, int32_t* out) {
+        __m256i acc[4] = { _mm256_setzero_si256(), _mm256_setzero_si256(),
+                           _mm256_setzero_si256(), _mm256_setzero_si256() };
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const __m256i va = widen(a + i);
+            FT_UNROLL for (size_t j = 0; j < 4; ++j)
+                acc[j] = _mm256_add_epi32(acc[j], _mm256_madd_epi16(va, widen(b + j * ldb + i)));
+        }
+        FT_UNROLL for (size_t j = 0; j < 4; ++j) {
+            int32_t s = hsum_epi32(acc[j]);
+            for (size_t t = i; t < n; ++t) s += int32_t(a[t]) * int32_t(b[j * ldb + t]);
+            out[j] = s;
+        }
+    }
+
+    // out[i * ldo + j] = a[i * lda] . b[j * ldb], i < kRows, j < 4
+    static constexpr size_t kRows = 2;
+    FT_AVX2 static void tile(const int8_t* a, size_t lda, const int8_t* b, size_t ldb, size_t n,
+                             int32_t* out, size_t ldo) {
+        __m256i acc[kRows][4];
+        FT_UNROLL for (size_t i = 0; i < kRows; ++i)
+            FT_UNROLL for (size_t j = 0; j < 4; ++j) acc[i][j] = _mm256_setzero_si256();
+        size_t p = 0;
+        for (; p + 16 <= n; p += 16) {
+            __m256i va[kRows];
+            FT_UNROLL for (size_t i = 0; i < kRows; ++i) va[i] = widen(a + i * lda + p);
+            FT_UNROLL for (size_t j = 0; j < 4; ++j) {
+                const __m256i vb = widen(b + j * ldb + p);
+                FT_UNROLL for (size_t i = 0; i < kRows; ++i)
+                    acc[i][j] = _mm256_add_epi32(acc[i][j], _mm256_madd_epi16(va[i], vb));
+            }
+        }
+        FT_UNROLL for (size_t i = 0; i < kRows; ++i)
+            FT_UNROLL for (size_t j = 0; j < 4; ++j) {
+                int32_t s = hsum_epi32(acc[i][j]);
+                for (size_t t = p; t < n; ++t) s += int32_t(a[i * lda + t]) * int32_t(b[j * ldb + t]);
+                out[i * ldo + j] = s;
+            }
+    }
+};
+
+// ------------------------------
+// VNNI: dpbusd multiplies u8 x s8 into int32 without saturation.
+// b is flipped to u8 (b + 128) and 128 * sum(a) taken off at the end.
+// ------------------------------
+#define FT_VNNI_KERNELS(ATTR, DPBUSD, ROWS)                                     \
+    ATTR static int32_t dot(const int8_t* a, const int8_t* b, size_t n) {       \
+        const __m256i flip = _mm256_set1_epi8(char(0x80)), ones = _mm256_set1_epi8(1); \
+        __m256i acc = _mm256_setzero_si256(), asum = _mm256_setzero_si256();    \
+        size_t i = 0;                                                           \
+        for (; i + 32 <= n; i += 32) {                                          \
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)); \
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)); \
+            acc = DPBUSD(acc, _mm256_xor_si256(vb, flip), va);                  \
+            asum = DPBUSD(asum, ones, va);                                      \
+        }                                                                       \
+        int32_t s = hsum_epi32(acc) - 128 * hsum_epi32(asum);                   \
+        for (; i < n; ++i) s += int32_t(a[i]) * int32_t(b[i]);                  \
+        return s;                                                               \
+    }                                                                           \
+    ATTR static void dot4(const int8_t* a, const int8_t* b, size_t ldb, size_t n, int32_t* out) { \
+        const __m256i flip = _mm256_set1_epi8(char(0x80)), ones = _mm256_set1_epi8(1); \
+        __m256i acc0 = _mm256_setzero_si256(), acc1 = acc0, acc2 = acc0, acc3 = acc0, asum = acc0; \
+        size_t i = 0;                                                           \
+        for (; i + 32 <= n; i += 32) {                                          \
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)); \
+            const int8_t* bi = b + i;                                           \
+            acc0 = DPBUSD(acc0, _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bi)), flip), va); \
+            acc1 = DPBUSD(acc1, _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bi + ldb)), flip), va); \
+            acc2 = DPBUSD(acc2, _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bi + 2 * ldb)), flip), va); \
+            acc3 = DPBUSD(acc3, _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bi + 3 * ldb)), flip), va); \
+            asum = DPBUSD(asum, ones, va);                                      \
+        }                                                                       \
+        int32_t corr = 128 * hsum_epi32(asum);                                  \
+        out[0] = hsum_epi32(acc0) - corr;                                       \
+        out[1] = hsum_epi32(acc1) - corr;                                       \
+        out[2] = hsum_epi32(acc2) - corr;                                       \
+        out[3] = hsum_epi32(acc3) - corr;                                       \
+        for (size_t j = 0; j < 4; ++j)                                          \
+            for (size_t t = i; t < n; ++t) out[j] += int32_t(a[t]) * int32_t(b[j * ldb + t]); \
+    }                                                                           \
+    /* ROWS x 4 register tile, sum(a) per row of a carries the correction */   \
+    static constexpr size_t kRows = ROWS;                                       \
+    ATTR static void tile(const int8_t* a, size_t lda, const int8_t* b, size_t ldb, size_t n, \
+                          int32_t* out, size_t ldo) {                           \
+        const __m256i flip = _mm256_set1_epi8(char(0x80)), ones = _mm256_set1_epi8(1); \
+        __m256i acc[ROWS][4], asum[ROWS];                                       \
+        FT_UNROLL for (size_t i = 0; i < ROWS; ++i) {                           \
+            asum[i] = _mm256_setzero_si256();                                   \
+            FT_UNROLL for (size_t j = 0; j < 4; ++j) acc[i][j] = asum[i];       \
+        }                                                                       \
+        size_t p = 0;                                                           \
+        for (; p + 32 <= n; p += 32) {                                          \
+            __m256i va[ROWS];                                                   \
+            FT_UNROLL for (size_t i = 0; i < ROWS; ++i) {                       \
+                va[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i * lda + p)); \
+                asum[i] = DPBUSD(asum[i], ones, va[i]);                         \
+            }                                                                   \
+            FT_UNROLL for (size_t j = 0; j < 4; ++j) {                          \
+                const __m256i vb = _mm256_xor_si256(                            \
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + j * ldb + p)), flip); \
+                FT_UNROLL for (size_t i = 0; i < ROWS; ++i) acc[i][j] = DPBUSD(acc[i][j], vb, va[i]); \
+            }                                                                   \
+        }                                                                       \
+        FT_UNROLL for (size_t i = 0; i < ROWS; ++i) {                           \
+            int32_t corr = 128 * hsum_epi32(asum[i]);                           \
+            FT_UNROLL for (size_t j = 0; j < 4; ++j) {                          \
+                int32_t s = hsum_epi32(acc[i][j]) - corr;                       \
+                for (size_t t = p; t < n; ++t) s += int32_t(a[i * lda + t]) * int32_t(b[j * ldb + t]); \
+                out[i * ldo + j] = s;                                           \
+            }                                                                   \
+        }                                                                       \
+    }
+
+// 4 x 4 tiles need 27 vector registers (AVX-512 has 32), 2 x 4 fit in 16
+struct AvxVnniQ : Avx2Q { FT_VNNI_KERNELS(FT_AVXVNNI, _mm256_dpbusd_avx_epi32, 2) };
+struct Vnni512Q : Avx2Q { FT_VNNI_KERNELS(FT_VNNI512, _mm256_dpbusd_epi32, 4) };
+
+struct F16cQ {
+    FT_F16C static float dot_half(const float* x, const uint16_t* h, size_t n) {
+        __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            s0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i),
+                                 _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i))), s0);
+            s1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8),
+                                 _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i + 8))), s1);
+        }
+        float lanes[8];
+        _mm256_storeu_ps(lanes, _mm256_add_ps(s0, s1));
+        float s = 0.f;
+        for (size_t j = 0; j < 8; ++j) s += lanes[j];
+        for (; i < n; ++i) s += x[i] * half_to_float(h[i]);
+        return s;
+    }
+    FT_F16C static void to_float(const uint16_t* h, float* out, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i))));
+        for (; i < n; ++i) out[i] = half_to_float(h[i]);
+    }
+    FT_F16C static void to_half(const float* x, uint16_t* out, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                             _mm256_cvtps_ph(_mm256_loadu_ps(x + i), _MM_FROUND_TO_NEAREST_INT));
+        for (; i < n; ++i) out[i] = half_from_float(x[i]);
+    }
+};
+#endif // FT_ARCH_X86
+
+#if defined(FT_ARCH_NEON) && defined(__aarch64__)
+// ------------------------------
+// NEON (AArch64). SDOT needs the dotprod extension at build time
+// (-march=armv8.2-a+dotprod); otherwise smull + pairwise accumulate.
+// ------------------------------
+struct NeonQ {
+    static int32x4_t round4(const float* x, float32x4_t inv, float32x4_t zp, float32x4_t lo, float32x4_t hi) {
+        float32x4_t r = vaddq_f32(vrndnq_f32(vmulq_f32(vld1q_f32(x), inv)), zp);
+        r = vbslq_f32(vceqq_f32(r, r), r, hi);   // vminq keeps NaN; send it to hi like x86 min
+        return vcvtq_s32_f32(vmaxq_f32(vminq_f32(r, hi), lo));
+    }
+
+    template <typename Q>
+    static void quantize(const float* x, size_t n, float inv_scale, int32_t zp, Q* out) {
+        const float32x4_t vi = vdupq_n_f32(inv_scale), vz = vdupq_n_f32(float(zp));
+        const float32x4_t lo = vdupq_n_f32(float(std::numeric_limits<Q>::min()));
+        const float32x4_t hi = vdupq_n_f32(float(std::numeric_limits<Q>::max()));
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            int16x8_t h = vcombine_s16(vqmovn_s32(round4(x + i, vi, vz, lo, hi)),
+                                       vqmovn_s32(round4(x + i + 4, vi, vz, lo, hi)));
+            if constexpr (std::is_signed<Q>::value) vst1_s8(reinterpret_cast<int8_t*>(out + i), vqmovn_s16(h));
+            else vst1_u8(reinterpret_cast<uint8_t*>(out + i), vqmovun_s16(h));
+        }
+        for (; i < n; ++i) out[i] = quantize_one<Q>(x[i], inv_scale, zp);
+    }
+
+    template <typename Q>
+    static void dequantize(const Q* q, size_t n, float scale, int32_t zp, float* out) {
+        const float32x4_t vs = vdupq_n_f32(scale);
+        const int32x4_t vz = vdupq_n_s32(zp);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            int16x8_t h;
+            if constexpr (std::is_signed<Q>::value) h = vmovl_s8(vld1_s8(reinterpret_cast<const int8_t*>(q + i)));
+            else h = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(reinterpret_cast<const uint8_t*>(q + i))));
+            int32x4_t l = vsubq_s32(vmovl_s16(vget_low_s16(h)), vz), u = vsubq_s32(vmovl_s16(vget_high_s16(h)), vz);
+            vst1q_f32(out + i, vmulq_f32(vcvtq_f32_s32(l), vs));
+            vst1q_f32(out + i + 4, vmulq_f32(vcvtq_f32_s32(u), vs));
+        }
+        for (; i < n; ++i) out[i] = float(int32_t(q[i]) - zp) * scale;
+    }
+
+    static int32x4_t mac16(int32x4_t acc, int8x16_t a, int8x16_t b) {
+#  if defined(__ARM_FEATURE_DOTPROD)
+        return vdotq_s32(acc, a, b);
+#  else
+        acc = vpadalq_s16(acc, vmull_s8(vget_low_s8(a), vget_low_s8(b)));
+        return vpadalq_s16(acc, vmull_high_s8(a, b));
+#  endif
+    }
+
+    static int32_t dot(const int8_t* a, const int8_t* b, size_t n) {
+        int32x4_t acc0 = vdupq_n_s32(0), acc1 = acc0;
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            acc0 = mac16(acc0, vld1q_s8(a + i), vld1q_s8(b + i));
+            acc1 = mac16(acc1, vld1q_s8(a + i + 16), vld1q_s8(b + i + 16));
+        }
+        int32_t s = vaddvq_s32(vaddq_s32(acc0, acc1));
+        for (; i < n; ++i) s += int32_t(a[i]) * int32_t(b[i]);
+        return s;
+    }
+
+    static void dot4(const int8_t* a, const int8_t* b, size_t ldb, size_t n, int32_t* out) {
+        int32x4_t acc[4] = { vdupq_n_s32(0), vdupq_n_s32(0), vdupq_n_s32(0), vdupq_n_s32(0) };
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const int8x16_t va = vld1q_s8(a + i);
+            FT_UNROLL for (size_t j = 0; j < 4; ++j) acc[j] = mac16(acc[j], va, vld1q_s8(b + j * ldb + i));
+        }
+        FT_UNROLL for (size_t j = 0; j < 4; ++j) {
+            int32_t s = vaddvq_s32(acc[j]);
+            for (size_t t = i; t < n; ++t) s += int32_t(a[t]) * int32_t(b[j * ldb + t]);
+            out[j] = s;
+        }
+    }
+
+    static constexpr size_t kRows = 4;
+    static void tile(const int8_t* a, size_t lda, const int8_t* b, size_t ldb, size_t n,
+                     int32_t* out, size_t ldo) {
+        int32x4_t acc[kRows][4];
+        FT_UNROLL for (size_t i = 0; i < kRows; ++i)
+            FT_UNROLL for (size_t j = 0; j < 4; ++j) acc[i][j] = vdupq_n_s32(0);
+        size_t p = 0;
+        for (; p + 16 <= n; p += 16) {
+            int8x16_t va[kRows];
+            FT_UNROLL for (size_t i = 0; i < kRows; ++i) va[i] = vld1q_s8(a + i * lda + p);
+            FT_UNROLL for (size_t j = 0; j < 4; ++j) {
+                const int8x16_t vb = vld1q_s8(b + j * ldb + p);
+                FT_UNROLL for (size_t i = 0; i < kRows; ++i) acc[i][j] = mac16(acc[i][j], va[i], vb);
+            }
+        }
+        FT_UNROLL for (size_t i = 0; i < kRows; ++i)
+            FT_UNROLL for (size_t j = 0; j < 4; ++j) {
+                int32_t s = vaddvq_s32(acc[i][j]);
+                for (size_t t = p; t < n; ++t) s += int32_t(a[i * lda + t]) * int32_t(b[j * ldb + t]);
+                out[i * ldo + j] = s;
+            }
+    }
+
+    static float dot_half(const float* x, const uint16_t* h, size_t n) {
+        float32x4_t s0 = vdupq_n_f32(0.f), s1 = s0;
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            s0 = vfmaq_f32(s0, vld1q_f32(x + i), vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(h + i))));
+            s1 = vfmaq_f32(s1, vld1q_f32(x + i + 4), vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(h + i + 4))));
+        }
+        float s = vaddvq_f32(vaddq_f32(s0, s1));
+        for (; i < n; ++i) s += x[i] * half_to_float(h[i]);
+        return s;
+    }
+
+    static void to_float(const uint16_t* h, float* out, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) vst1q_f32(out + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(h + i))));
+        for (; i < n; ++i) out[i] = half_to_float(h[i]);
+    }
+
+    static void to_half(const float* x, uint16_t* out, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) vst1_u16(out + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(x + i))));
+        for (; i < n; ++i) out[i] = half_from_float(x[i]);
+    }
+};
+#endif
+
+// ------------------------------
+// Dispatch table
+// ------------------------------
+struct QuantTable {
+    void (*quantize_s8)(const float*, size_t, float, int32_t, int8_t*);
+    void (*quantize_u8)(const float*, size_t, float, int32_t, uint8_t*);
+    void (*dequantize_s8)(const int8_t*, size_t, float, int32_t, float*);
+    void (*dequantize_u8)(const uint8_t*, size_t, float, int32_t, float*);
+    int32_t (*dot)(const int8_t*, const int8_t*, size_t);
+    void (*dot4)(const int8_t*, const int8_t*, size_t, size_t, int32_t*);   // a . b[j * ldb], j < 4
+    void (*tile)(const int8_t*, size_t, const int8_t*, size_t, size_t, int32_t*, size_t);
+    size_t tile_rows = 1;                                                    // rows of a per tile
+    float (*dot_half)(const float*, const uint16_t*, size_t);
+    void (*to_float)(const uint16_t*, float*, size_t);
+    void (*to_half)(const float*, uint16_t*, size_t);
+    const char* dot_isa = "scalar";
+
+    template <typename Q> void quantize(const float* x, size_t n, float inv, int32_t zp, Q* out) const {
+        if constexpr (std::is_signed<Q>::value) quantize_s8(x, n, inv, zp, out);
+        else quantize_u8(x, n, inv, zp, out);
+    }
+    template <typename Q> void dequantize(const Q* q, size_t n, float scale, int32_t zp, float* out) const {
+        if constexpr (std::is_signed<Q>::value) dequantize_s8(q, n, scale, zp, out);
+        else dequantize_u8(q, n, scale, zp, out);
+    }
+};
+
+template <typename Tr>
+void set_convert(QuantTable& t) {
+    t.quantize_s8 = &Tr::template quantize<int8_t>;
+    t.quantize_u8 = &Tr::template quantize<uint8_t>;
+    t.dequantize_s8 = &Tr::template dequantize<int8_t>;
+    t.dequantize_u8 = &Tr::template dequantize<uint8_t>;
+}
+
+template <typename Tr>
+void set_dot(QuantTable& t, const char* name) {
+    t.dot = &Tr::dot;
+    t.dot4 = &Tr::dot4;
+    t.tile = &Tr::tile;
+    t.tile_rows = Tr::kRows;
+    t.dot_isa = name;
+}
+
+inline QuantTable select_quant_table(Isa isa) {
+    QuantTable t;
+    set_convert<ScalarQ>(t);
+    set_dot<ScalarQ>(t, "scalar");
+    t.to_float = &ScalarQ::to_float;
+    t.dot_half = &ScalarQ::dot_half;
+    t.to_half = &ScalarQ::to_half;
+#if defined(FT_ARCH_X86) && (defined(__GNUC__) || defined(__clang__))
+    if (isa >= Isa::Avx2) {
+        set_convert<Avx2Q>(t);
+        if (isa == Isa::Avx512 && __builtin_cpu_supports("avx512vnni") && __builtin_cpu_supports("avx512vl"))
+            set_dot<Vnni512Q>(t, "avx512vnni");
+        else if (__builtin_cpu_supports("avxvnni"))
+            set_dot<AvxVnniQ>(t, "avxvnni");
+        else
+            set_dot<Avx2Q>(t, "avx2");
+        if (__builtin_cpu_supports("f16c")) {
+            t.to_float = &F16cQ::to_float;
+            t.dot_half = &F16cQ::dot_half;
+            t.to_half = &F16cQ::to_half;
+        }
+    }
+#elif defined(FT_ARCH_NEON) && defined(__aarch64__)
+    if (isa == Isa::Neon) {
+        set_convert<NeonQ>(t);
+#  if defined(__ARM_FEATURE_DOTPROD)
+        set_dot<NeonQ>(t, "neon-sdot");
+#  else
+        set_dot<NeonQ>(t, "neon");
+#  endif
+        t.to_float = &NeonQ::to_float;
+        t.dot_half = &NeonQ::dot_half;
+        t.to_half = &NeonQ::to_half;
+    }
+#endif
+    (void)isa;
+    return t;
+}
+
+inline const QuantTable& quant_kernels() {
+    static const QuantTable table = select_quant_table(active_isa());
+    return table;
+}
+
+} // namespace simd
+
+// =====================
+// Quant: int8 / uint8 tensors on Pv
+// =====================
+template <typename Q>
+struct Quant {
+    static_assert(std::is_same<Q, int8_t>::value || std::is_same<Q, uint8_t>::value,
+                  "Quant supports int8_t and uint8_t");
+    using PvF = Pv<float>;
+    using PvQ = Pv<Q>;
+
+    static constexpr size_t kChunk = 16384;
+    static constexpr size_t kBlock = 256;
+    static constexpr int32_t qmin = std::numeric_limits<Q>::min();
+    static constexpr int32_t qmax = std::numeric_limits<Q>::max();
+
+    // ------------------------------
+    // Parameters from the range of x; per-tensor when axis < 0.
+    // Symmetric keeps real 0 at the centre code (0 for int8, 128 for uint8)
+    // ------------------------------
+    static QParams choose(const PvF& x, bool symmetric = true, long axis = -1) {
+        if (x.size() == 0) throw std::runtime_error("quantize: empty tensor");
+        QParams p;
+        std::vector<float> lo, hi;
+        if (axis < 0) {
+            Ops<float>::nonempty(x, "quantize");
+            auto acc = Ops<float>::summarize(x, { StatKind::Min, StatKind::Max });
+            lo = { acc.min };
+            hi = { acc.max };
+        } else {
+            if (size_t(axis) >= x.shape.size()) throw std::runtime_error("quantize: axis out of range");
+            std::vector<size_t> rest;
+            for (size_t d = 0; d < x.shape.size(); ++d) if (d != size_t(axis)) rest.push_back(d);
+            lo = Ops<float>::min(x, rest).to_vector();
+            hi = Ops<float>::max(x, rest).to_vector();
+            p.axis = size_t(axis);
+        }
+        p.scale.assign(lo.size(), 1.f);
+        p.zero_point.assign(lo.size(), 0);
+        for (size_t c = 0; c < lo.size(); ++c) {
+            float l = std::min(lo[c], 0.f), h = std::max(hi[c], 0.f);
+            if (symmetric) {
+                float m = std::max(-l, h);
+                p.scale[c] = m > 0 ? m / 127.f : 1.f;
+                p.zero_point[c] = std::is_signed<Q>::value ? 0 : 128;
+            } else {
+                float s = (h - l) / float(qmax - qmin);
+                p.scale[c] = s > 0 ? s : 1.f;
+                int32_t z = qmin - int32_t(std::nearbyint(l / p.scale[c]));
+                p.zero_point[c] = std::min(qmax, std::max(qmin, z));
+            }
+        }
+        return p;
+    }
+
+    static void check(const std::vector<size_t>& shape, const QParams& p) {
+        if (p.scale.empty() || p.scale.size() != p.zero_point.size())
+            throw std::runtime_error("quantize: scale and zero_point sizes differ");
+        if (p.per_channel() && (p.axis >= shape.size() || shape[p.axis] != p.scale.size()))
+            throw std::runtime_error("quantize: one scale per channel expected");
+        for (auto z : p.zero_point)
+            if (z < qmin || z > qmax) throw std::runtime_error("quantize: zero_point out of range");
+    }
+
+    // Elements in one channel before the channel index moves on
+    static size_t inner(const std::vector<size_t>& shape, const QParams& p) {
+        if (!p.per_channel()) return size_t(-1);
+        size_t n = 1;
+        for (size_t d = p.axis + 1; d < shape.size(); ++d) n *= shape[d];
+        return n;
+    }
+
+    // fn(begin, count, channel) over [lo, hi) of the flat contiguous data
+    template <typename Fn>
+    static void segments(size_t lo, size_t hi, size_t in, size_t channels, Fn&& fn) {
+        while (lo < hi) {
+            size_t c = channels > 1 ? (lo / in) % channels : 0;
+            size_t end = channels > 1 ? std::min(hi, (lo / in + 1) * in) : hi;
+            fn(lo, end - lo, c);
+            lo = end;
+        }
+    }
+
+    static PvQ quantize(const PvF& x, const QParams& p) {
+        check(x.shape, p);
+        PvF cx = x.contiguous();
+        PvQ out;
+        out.shape = x.shape;
+        out.computeStrides();
+        out.buf = std::make_shared<Buffer<Q>>(cx.size());
+        const float* src = cx.data();
+        Q* dst = out.buf->ptr;
+        size_t in = inner(x.shape, p);
+        const auto& kt = simd::quant_kernels();
+        Executor::global().parallel_for(0, cx.size(), kChunk, [&](size_t lo, size_t hi) {
+            segments(lo, hi, in, p.scale.size(), [&](size_t b, size_t n, size_t c) {
+                kt.quantize(src + b, n, 1.f / p.scale[c], p.zero_point[c], dst + b);
+            });
+        });
+        return out;
+    }
+
+    static PvF dequantize(const PvQ& q, const QParams& p) {
+        check(q.shape, p);
+        PvQ cq = q.contiguous();
+        PvF out(q.shape);
+        const Q* src = cq.data();
+        float* dst = out.buf->ptr;
+        size_t in = inner(q.shape, p);
+        const auto& kt = simd::quant_kernels();
+        Executor::global().parallel_for(0, cq.size(), kChunk, [&](size_t lo, size_t hi) {
+            segments(lo, hi, in, p.scale.size(), [&](size_t b, size_t n, size_t c) {
+                kt.dequantize(src + b, n, p.scale[c], p.zero_point[c], dst + b);
+            });
+        });
+        return out;
+    }
+
+    // ------------------------------
+    // Element-wise a op b requantized to out, same shapes. Blocks are
+    // dequantized to the stack, combined by the float kernels and
+    // quantized straight back
+    // ------------------------------
+    static PvQ binary(OpKind op, const PvQ& a, const QParams& pa, const PvQ& b, const QParams& pb,
+                      const QParams& po) {
+        if (size_t(op) >= simd::kBinaryOps) throw std::runtime_error("quantized op: not a binary op");
+        if (a.shape != b.shape) throw std::runtime_error("quantized op: shape mismatch");
+        check(a.shape, pa);
+        check(b.shape, pb);
+        check(a.shape, po);
+        PvQ ca = a.contiguous(), cb = b.contiguous();
+        PvQ out;
+        out.shape = a.shape;
+        out.computeStrides();
+        out.buf = std::make_shared<Buffer<Q>>(ca.size());
+
+        const Q* sa = ca.data();
+        const Q* sb = cb.data();
+        Q* dst = out.buf->ptr;
+        size_t ia = inner(a.shape, pa), ib = inner(a.shape, pb), io = inner(a.shape, po);
+        const auto& kt = simd::quant_kernels();
+        auto fn = simd::kernels<float>().binary[size_t(op)];
+
+        Executor::global().parallel_for(0, ca.size(), kChunk, [&](size_t lo, size_t hi) {
+            float fa[kBlock], fb[kBlock];
+            for (size_t b0 = lo; b0 < hi; b0 += kBlock) {
+                size_t b1 = std::min(hi, b0 + kBlock);
+                segments(b0, b1, ia, pa.scale.size(), [&](size_t s, size_t n, size_t c) {
+                    kt.dequantize(sa + s, n, pa.scale[c], pa.zero_point[c], fa + (s - b0));
+                });
+                segments(b0, b1, ib, pb.scale.size(), [&](size_t s, size_t n, size_t c) {
+                    kt.dequantize(sb + s, n, pb.scale[c], pb.zero_point[c], fb + (s - b0));
+                });
+                fn(fa, fb, fa, b1 - b0);
+                segments(b0, b1, io, po.scale.size(), [&](size_t s, size_t n, size_t c) {
+                    kt.quantize(fa + (s - b0), n, 1.f / po.scale[c], po.zero_point[c], dst + s);
+                });
+            }
+        }, 4);
+        return out;
+    }
+
+    // ------------------------------
+    // Products
+    // ------------------------------
+    // a as contiguous int8 with the zero-point moved along (uint8 - 128)
+    static Pv<int8_t> as_s8(const PvQ& a, int32_t& zp_shift) {
+        if constexpr (std::is_signed<Q>::value) {
+            zp_shift = 0;
+            return a.contiguous();
+        } else {
+            zp_shift = 128;
+            Pv<int8_t> r;
+            r.shape = a.shape;
+            r.computeStrides();
+            r.buf = std::make_shared<Buffer<int8_t>>(a.size());
+            int8_t* dst = r.buf->ptr;
+            const uint8_t* src = a.buf->ptr;
+            for_each_run(a.shape, a.strides, a.offset, [&](size_t off, size_t n, size_t st) {
+                for (size_t i = 0; i < n; ++i) *dst++ = int8_t(int32_t(src[off + i * st]) - 128);
+            });
+            return r;
+        }
+    }
+
+    // out[i, j] = sum_p a[i, p] * b[j, p]; a is m x k, b is n x k, both
+    // contiguous. Register tiles of tile_rows x 4, four rows of b stay in
+    // L1 while a block of a streams past
+    static void gemm_s8(size_t m, size_t n, size_t k, const int8_t* a, const int8_t* b, int32_t* out) {
+        const auto& kt = simd::quant_kernels();
+        const size_t quads = (n + 3) / 4, R = kt.tile_rows, rows = 64;
+        Executor::global().parallel_for(0, quads, 1, [&](size_t lo, size_t hi) {
+            for (size_t i0 = 0; i0 < m; i0 += rows) {
+                size_t i1 = std::min(m, i0 + rows);
+                for (size_t q = lo; q < hi; ++q) {
+                    size_t j = q * 4;
+                    if (j + 4 > n) {
+                        for (size_t i = i0; i < i1; ++i)
+                            for (size_t t = j; t < n; ++t) out[i * n + t] = kt.dot(a + i * k, b + t * k, k);
+                        continue;
+                    }
+                    size_t i = i0;
+                    for (; i + R <= i1; i += R) kt.tile(a + i * k, k, b + j * k, k, k, out + i * n + j, n);
+                    for (; i < i1; ++i) kt.dot4(a + i * k, b + j * k, k, k, out + i * n + j);
+                }
+            }
+        }, std::max<size_t>(1, m * k / 16));
+    }
+
+    // ------------------------------
+    // y = act(scale_a * scale_w[j] * (x q_w^T)[i, j] + bias[j]) with the
+    // zero-point terms removed. x is m x k int8 (per-tensor), w is n x k
+    // int8 (per-tensor or per row)
+    // ------------------------------
+    static void product(size_t m, size_t n, size_t k,
+                        const int8_t* x, float sx, int32_t zx,
+                        const int8_t* w, const QParams& pw, int32_t wshift,
+                        float* y, const Epilogue<float>& ep) {
+        std::vector<int32_t> acc(m * n);
+        gemm_s8(m, n, k, x, w, acc.data());
+
+        bool wzero = true;
+        for (auto z : pw.zero_point) wzero = wzero && z - wshift == 0;
+        std::vector<int32_t> xsum(m, 0), wsum(n, 0);
+        if (!wzero)
+            for (size_t i = 0; i < m; ++i)
+                for (size_t p = 0; p < k; ++p) xsum[i] += x[i * k + p];
+        if (zx != 0)
+            for (size_t j = 0; j < n; ++j)
+                for (size_t p = 0; p < k; ++p) wsum[j] += w[j * k + p];
+
+        bool pc = pw.per_channel();
+        Executor::global().parallel_for(0, m, std::max<size_t>(1, kChunk / n), [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i)
+                for (size_t j = 0; j < n; ++j) {
+                    int64_t zw = pw.zero_point[pc ? j : 0] - wshift;
+                    int64_t v = int64_t(acc[i * n + j]) - zw * xsum[i] - int64_t(zx) * wsum[j] + int64_t(k) * zx * zw;
+                    y[i * n + j] = float(v) * sx * pw.scale[pc ? j : 0];
+                }
+            Gemm<float>::finish(y + lo * n, n, hi - lo, n, 0, ep);
+        }, n);
+    }
+
+    // a [..., K] per-tensor times b [K, N], per-tensor or per-column
+    template <typename R>
+    static PvF matmul(const PvQ& a, const QParams& pa, const Pv<R>& b, const QParams& pb) {
+        if (a.shape.empty() || b.shape.size() != 2 || a.shape.back() != b.shape[0])
+            throw std::runtime_error("quantized matmul: expects [..., K] x [K, N]");
+        if (pa.per_channel()) throw std::runtime_error("quantized matmul: left operand must be per-tensor");
+        if (pb.per_channel() && pb.axis != 1)
+            throw std::runtime_error("quantized matmul: right operand must be per-tensor or per-column");
+        check(a.shape, pa);
+        Quant<R>::check(b.shape, pb);
+        QParams pw = pb;
+        pw.axis = 0;
+        return linear_q(a, pa, Quant<R>::transposed(b), pw, PvF(), Activation::None);
+    }
+
+    // b^T as a contiguous copy
+    static PvQ transposed(const PvQ& b) { return b.transpose().copy(); }
+
+    // act(x w^T + bias): x [..., K] per-tensor, w [N, K] per-tensor or per-row
+    template <typename R>
+    static PvF linear_q(const PvQ& x, const QParams& px, const Pv<R>& w, const QParams& pw,
+                        const PvF& bias, Activation act) {
+        if (w.shape.size() != 2 || x.shape.empty() || x.shape.back() != w.shape[1])
+            throw std::runtime_error("quantized linear: expects x [..., in] and w [out, in]");
+        if (px.per_channel()) throw std::runtime_error("quantized linear: input must be per-tensor");
+        if (pw.per_channel() && pw.axis != 0)
+            throw std::runtime_error("quantized linear: weight must be per-tensor or per-row");
+        size_t k = w.shape[1], n = w.shape[0], m = x.size() / std::max<size_t>(1, k);
+
+        int32_t xshift, wshift;
+        Pv<int8_t> xs = as_s8(x, xshift);
+        Pv<int8_t> ws = Quant<R>::as_s8(w, wshift);
+
+        Epilogue<float> ep = bias_epilogue(bias, n, act);
+        std::vector<size_t> shp = x.shape;
+        shp.back() = n;
+        PvF y(shp);
+        product(m, n, k, xs.data(), px.scale[0], px.zero_point[0] - xshift,
+                ws.data(), pw, wshift, y.buf->ptr, ep);
+        return y;
+    }
+
+    // Float input quantized on the fly (symmetric, per-tensor)
+    static PvF linear(const PvF& x, const PvQ& w, const QParams& pw, const PvF& bias, Activation act) {
+        QParams px = Quant<int8_t>::choose(x, true);
+        return Quant<int8_t>::linear_q(Quant<int8_t>::quantize(x, px), px, w, pw, bias, act);
+    }
+
+    // Flat dot product of two per-tensor quantized tensors, int32 per chunk
+    template <typename R>
+    static float dot(const PvQ& a, const QParams& pa, const Pv<R>& b, const QParams& pb) {
+        if (a.size() != b.size()) throw std::runtime_error("dot: size mismatch");
+        if (pa.per_channel() || pb.per_channel()) throw std::runtime_error("quantized dot: per-tensor only");
+        int32_t sa, sb;
+        Pv<int8_t> xa = as_s8(a, sa);
+        Pv<int8_t> xb = Quant<R>::as_s8(b, sb);
+        const int8_t* pa8 = xa.data();
+        const int8_t* pb8 = xb.data();
+        int64_t za = pa.zero_point[0] - sa, zb = pb.zero_point[0] - sb;
+        const auto& kt = simd::quant_kernels();
+        // sum (a - za)(b - zb) = sum ab - zb sum a - za sum b + n za zb
+        int64_t raw = Executor::global().parallel_reduce(0, xa.size(), kChunk, int64_t(0),
+            [&](size_t lo, size_t hi) {
+                int64_t s = kt.dot(pa8 + lo, pb8 + lo, hi - lo);
+                if (zb || za) {
+                    int64_t suma = 0, sumb = 0;
+                    for (size_t i = lo; i < hi; ++i) { suma += pa8[i]; sumb += pb8[i]; }
+                    s += -zb * suma - za * sumb + int64_t(hi - lo) * za * zb;
+                }
+                return s;
+            },
+            [](int64_t x, int64_t y) { return x + y; });
+        return float(double(raw) * pa.scale[0] * pb.scale[0]);
+    }
+
+    static Epilogue<float> bias_epilogue(const PvF& bias, size_t n, Activation act) {
+        Epilogue<float> ep;
+        ep.act = act;
+        if (bias.size() != 0) {
+            if (bias.shape.size() != 1 || bias.shape[0] != n)
+                throw std::runtime_error("linear: bias must be [out]");
+            ep.bias = bias.data();
+            ep.bias_stride = bias.strides[0];
+        }
+        return ep;
+    }
+};
+
+// =====================
+// HalfOps: fp16 storage, fp32 compute
+// =====================
+struct HalfOps {
+    static constexpr size_t kChunk = 16384;
+    static constexpr size_t kRows = 256;   // weight rows widened per GEMM call
+
+    static Pv<Half> to_half(const Pv<float>& x) {
+        Pv<float> cx = x.contiguous();
+        Pv<Half> out;
+        out.shape = x.shape;
+        out.computeStrides();
+        out.buf = std::make_shared<Buffer<Half>>(cx.size());
+        const float* src = cx.data();
+        uint16_t* dst = reinterpret_cast<uint16_t*>(out.buf->ptr);
+        const auto& kt = simd::quant_kernels();
+        Executor::global().parallel_for(0, cx.size(), kChunk, [&](size_t lo, size_t hi) {
+            kt.to_half(src + lo, dst + lo, hi - lo);
+        });
+        return out;
+    }
+
+    static Pv<float> to_float(const Pv<Half>& h) {
+        Pv<Half> ch = h.contiguous();
+        Pv<float> out(h.shape);
+        const uint16_t* src = reinterpret_cast<const uint16_t*>(ch.data());
+        float* dst = out.buf->ptr;
+        const auto& kt = simd::quant_kernels();
+        Executor::global().parallel_for(0, ch.size(), kChunk, [&](size_t lo, size_t hi) {
+            kt.to_float(src + lo, dst + lo, hi - lo);
+        });
+        return out;
+    }
+
+    // act(x w^T + bias): x [..., in] float, w [out, in] half. Weight rows
+    // are widened to fp32 just before use, never as a whole
+    static Pv<float> linear(const Pv<float>& x, const Pv<Half>& w, const Pv<float>& bias, Activation act) {
+        if (w.shape.size() != 2 || x.shape.empty() || x.shape.back() != w.shape[1])
+            throw std::runtime_error("half linear: expects x [..., in] and w [out, in]");
+        size_t k = w.shape[1], n = w.shape[0], m = x.size() / std::max<size_t>(1, k);
+        Pv<float> cx = x.contiguous();
+        Pv<Half> cw = w.contiguous();
+        const float* xp = cx.data();
+        const uint16_t* wp = reinterpret_cast<const uint16_t*>(cw.data());
+        Epilogue<float> ep = Quant<int8_t>::bias_epilogue(bias, n, act);
+
+        std::vector<size_t> shp = x.shape;
+        shp.back() = n;
+        Pv<float> y(shp);
+        float* yp = y.buf->ptr;
+        const auto& qt = simd::quant_kernels();
+
+        if (m <= 4) {
+            // GEMV: weights widened in registers inside the dot product
+            Executor::global().parallel_for(0, n, std::max<size_t>(1, kChunk / std::max<size_t>(1, k)),
+                [&](size_t lo, size_t hi) {
+                    for (size_t j = lo; j < hi; ++j)
+                        for (size_t i = 0; i < m; ++i) yp[i * n + j] = qt.dot_half(xp + i * k, wp + j * k, k);
+                }, k * m);
+            Gemm<float>::finish(yp, n, m, n, 0, ep);
+            return y;
+        }
+
+        std::vector<float> block(std::min(kRows, n) * k);
+        for (size_t j0 = 0; j0 < n; j0 += kRows) {
+            size_t nb = std::min(kRows, n - j0);
+            Executor::global().parallel_for(0, nb, 16, [&](size_t lo, size_t hi) {
+                qt.to_float(wp + (j0 + lo) * k, block.data() + lo * k, (hi - lo) * k);
+            }, k);
+            Epilogue<float> part = ep;
+            if (part.bias) part.bias += j0 * part.bias_stride;
+            Gemm<float>::run(m, nb, k, { xp, k, 1 }, { block.data(), 1, k }, yp + j0, n, part);
+        }
+        return y;
+    }
+};
@@ -0,0 +1,882 @@
+#pragma once
+
+#include "pch.tpp"
+#include "vmath.tpp"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define FT_ARCH_X86 1
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define FT_ARCH_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* SIMD backend.
+   One vector kernel per op type and ISA, selected once by CPU feature
+   detection so a single binary runs the widest path the host supports. */
+
+#if defined(__GNUC__) || defined(__clang__)
+#define FT_TARGET(isa) __attribute__((target(isa)))
+#else
+#define FT_TARGET(isa)
+#endif
+
+#define FT_SSE42  FT_TARGET("sse4.2")
+#define FT_AVX2   FT_TARGET("avx2,fma")
+#define FT_AVX512 FT_TARGET("avx512f,avx2,fma")
+
+// ------------------------------
+// Element-wise op kinds understood by the kernels
+// ------------------------------
+enum class OpKind : uint8_t {
+    Add, Sub, Mul, Div, Min, Max,  // binary, table-indexed
+    Fma,                           // a * b + c
+    Unary,                         // one-input math op, see UnaryKind
+    Custom                         // user std::function, scalar only
+};
+
+namespace simd {
+
+constexpr size_t kBinaryOps = 6;
+
+enum class Isa : uint8_t { Scalar, Neon, Sse42, Avx2, Avx512 };
+
+inline const char* isa_name(Isa isa) {
+    switch (isa) {
+        case Isa::Neon:   return "neon";
+        case Isa::Sse42:  return "sse4.2";
+        case Isa::Avx2:   return "avx2";
+        case Isa::Avx512: return "avx512";
+        default:          return "scalar";
+    }
+}
+
+// ------------------------------
+// Reference semantics, also used for vector tails
+// ------------------------------
+template <OpKind K, typename T>
+inline T scalar_apply(T a, T b) {
+    if constexpr (K == OpKind::Add) return a + b;
+    else if constexpr (K == OpKind::Sub) return a - b;
+    else if constexpr (K == OpKind::Mul) return a * b;
+    else if constexpr (K == OpKind::Div) return a / b;
+    else if constexpr (K == OpKind::Min) return a < b ? a : b;
+    else return b < a ? a : b;
+}
+
+// Kernel bodies shared by every vector backend. Expanded inside a traits
+// struct that provides T, V, W, load/store/set1/apply<K>/fma for one ISA,
+// with ATTR enabling that ISA on the generated functions.
+#define FT_SIMD_KERNELS(ATTR)                                                   \
+    template <OpKind K>                                                         \
+    ATTR static void binary(const T* a, const T* b, T* o, size_t n) {           \
+        size_t i = 0;                                                           \
+        for (; i + W <= n; i += W)                                              \
+            store(o + i, apply<K>(load(a + i), load(b + i)));                   \
+        for (; i < n; ++i) o[i] = scalar_apply<K>(a[i], b[i]);                  \
+    }                                                                           \
+    template <OpKind K>                                                         \
+    ATTR static void scalar(const T* a, T s, T* o, size_t n) {                  \
+        const V vs = set1(s);                                                   \
+        size_t i = 0;                                                           \
+        for (; i + W <= n; i += W)                                              \
+            store(o + i, apply<K>(load(a + i), vs));                            \
+        for (; i < n; ++i) o[i] = scalar_apply<K>(a[i], s);                     \
+    }                                                                           \
+    ATTR static void fused(const T* a, const T* b, const T* c, T* o, size_t n) {\
+        size_t i = 0;                                                           \
+        for (; i + W <= n; i += W)                                              \
+            store(o + i, fma(load(a + i), load(b + i), load(c + i)));           \
+        for (; i < n; ++i) o[i] = a[i] * b[i] + c[i];                           \
+    }                                                                           \
+    ATTR static void fused_scalar(const T* a, T s, T t, T* o, size_t n) {       \
+        const V vs = set1(s), vt = set1(t);                                     \
+        size_t i = 0;                                                           \
+        for (; i + W <= n; i += W)                                              \
+            store(o + i, fma(load(a + i), vs, vt));                             \
+        for (; i < n; ++i) o[i] = a[i] * s + t;                                 \
+    }                                                                           \
+    /* out = { sum, min, max } of a[0, n), n >= 1, one read */                  \
+    ATTR static void summary(const T* a, size_t n, T* out) {                    \
+        T s = T(), mn = a[0], mx = a[0];                                        \
+        size_t i = 0;                                                           \
+        if (n >= 2 * W) {                                                       \
+            V s0 = set1(T()), s1 = set1(T()), lo = load(a), hi = lo;            \
+            for (; i + 2 * W <= n; i += 2 * W) {                                \
+                V x0 = load(a + i), x1 = load(a + i + W);                       \
+                s0 = apply<OpKind::Add>(s0, x0);                                \
+                s1 = apply<OpKind::Add>(s1, x1);                                \
+                lo = apply<OpKind::Min>(lo, apply<OpKind::Min>(x0, x1));        \
+                hi = apply<OpKind::Max>(hi, apply<OpKind::Max>(x0, x1));        \
+            }                                                                   \
+            T ls[W], ll[W], lh[W];                                              \
+            store(ls, apply<OpKind::Add>(s0, s1));                              \
+            store(ll, lo);                                                      \
+            store(lh, hi);                                                      \
+            for (size_t j = 0; j < W; ++j) {                                    \
+                s += ls[j];                                                     \
+                mn = scalar_apply<OpKind::Min>(mn, ll[j]);                      \
+                mx = scalar_apply<OpKind::Max>(mx, lh[j]);                      \
+            }                                                                   \
+        }                                                                       \
+        for (; i < n; ++i) {                                                    \
+            s += a[i];                                                          \
+            mn = scalar_apply<OpKind::Min>(mn, a[i]);                           \
+            mx = scalar_apply<OpKind::Max>(mx, a[i]);                           \
+        }                                                                       \
+        out[0] = s; out[1] = mn; out[2] = mx;                                   \
+    }
+
+// Floating-point only kernels, expanded in traits that provide vsqrt
+#define FT_SIMD_FLOAT(ATTR)                                                     \
+    ATTR static void root(const T* a, T* o, size_t n) {                         \
+        size_t i = 0;                                                           \
+        for (; i + W <= n; i += W) store(o + i, vsqrt(load(a + i)));            \
+        for (; i < n; ++i) o[i] = std::sqrt(a[i]);                              \
+    }                                                                           \
+    /* sum of (a[i] - m)^2 */                                                   \
+    ATTR static T sqdev(const T* a, size_t n, T m) {                            \
+        const V vm = set1(m);                                                   \
+        V acc = set1(T());                                                      \
+        size_t i = 0;                                                           \
+        for (; i + W <= n; i += W) {                                            \
+            V d = apply<OpKind::Sub>(load(a + i), vm);                          \
+            acc = fma(d, d, acc);                                               \
+        }                                                                       \
+        T lanes[W];                                                             \
+        store(lanes, acc);                                                      \
+        T s = T();                                                              \
+        for (size_t j = 0; j < W; ++j) s += lanes[j];                           \
+        for (; i < n; ++i) { T d = a[i] - m; s += d * d; }                      \
+        return s;                                                               \
+    }
+
+// ------------------------------
+// Portable fallback, any arithmetic T
+// ------------------------------
+template <typename T>
+struct Generic {
+    static constexpr bool has_div = true;
+    static constexpr bool has_sqrt = true;
+
+    template <OpKind K>
+    static void binary(const T* a, const T* b, T* o, size_t n) {
+        for (size_t i = 0; i < n; ++i) o[i] = scalar_apply<K>(a[i], b[i]);
+    }
+    template <OpKind K>
+    static void scalar(const T* a, T s, T* o, size_t n) {
+        for (size_t i = 0; i < n; ++i) o[i] = scalar_apply<K>(a[i], s);
+    }
+    static void fused(const T* a, const T* b, const T* c, T* o, size_t n) {
+        for (size_t i = 0; i < n; ++i) o[i] = a[i] * b[i] + c[i];
+    }
+    static void fused_scalar(const T* a, T s, T t, T* o, size_t n) {
+        for (size_t i = 0; i < n; ++i) o[i] = a[i] * s + t;
+    }
+    static void root(const T* a, T* o, size_t n) {
+        for (size_t i = 0; i < n; ++i) o[i] = static_cast<T>(std::sqrt(a[i]));
+    }
+    static void summary(const T* a, size_t n, T* out) {
+        T s = T(), mn = a[0], mx = a[0];
+        for (size_t i = 0; i < n; ++i) {
+            s += a[i];
+            mn = scalar_apply<OpKind::Min>(mn, a[i]);
+            mx = scalar_apply<OpKind::Max>(mx, a[i]);
+        }
+        out[0] = s; out[1] = mn; out[2] = mx;
+    }
+    static T sqdev(const T* a, size_t n, T m) {
+        T s = T();
+        for (size_t i = 0; i < n; ++i) { T d = a[i] - m; s += d * d; }
+        return s;
+    }
+
+    // Math through libm, see ScalarMath
+    using Sm = ScalarMath<T>;
+    using F = math_t<T>;
+    static void exp(const T* a, T* o, size_t n) { for (size_t i = 0; i < n; ++i) o[i] = Sm::exp(a[i]); }
+    static void log(const T* a, T* o, size_t n) { for (size_t i = 0; i < n; ++i) o[i] = Sm::log(a[i]); }
+    static void sin(const T* a, T* o, size_t n) { for (size_t i = 0; i < n; ++i) o[i] = Sm::sin(a[i]); }
+    static void cos(const T* a, T* o, size_t n) { for (size_t i = 0; i < n; ++i) o[i] = Sm::cos(a[i]); }
+    static void tanh(const T* a, T* o, size_t n) { for (size_t i = 0; i < n; ++i) o[i] = Sm::tanh(a[i]); }
+    static void sigmoid(const T* a, T* o, size_t n) { for (size_t i = 0; i < n; ++i) o[i] = Sm::sigmoid(a[i]); }
+    static void gelu(const T* a, T* o, size_t n) { for (size_t i = 0; i < n; ++i) o[i] = Sm::gelu(a[i]); }
+    static void pow(const T* a, T p, T* o, size_t n) { for (size_t i = 0; i < n; ++i) o[i] = Sm::pow(a[i], p); }
+
+    // Online max and sum of e^(x - max): one read for the statistics
+    static void row_max_sum(const T* x, size_t n, F& mx, F& s) {
+        mx = std::numeric_limits<F>::lowest();
+        s = F();
+        for (size_t i = 0; i < n; ++i) {
+            F v = F(x[i]);
+            if (mx < v) { s *= std::exp(mx - v); mx = v; }
+            s += std::exp(v - mx);
+        }
+    }
+    static void softmax(const T* x, T* y, size_t n) {
+        F mx, s;
+        row_max_sum(x, n, mx, s);
+        for (size_t i = 0; i < n; ++i) y[i] = static_cast<T>(std::exp(F(x[i]) - mx) / s);
+    }
+    static void log_softmax(const T* x, T* y, size_t n) {
+        F mx, s;
+        row_max_sum(x, n, mx, s);
+        F ls = std::log(s);
+        for (size_t i = 0; i < n; ++i) y[i] = static_cast<T>((F(x[i]) - mx) - ls);
+    }
+    static void affine(const T* x, T* y, size_t n, F shift, F scale, const T* gamma, const T* beta) {
+        for (size_t i = 0; i < n; ++i) {
+            F t = (F(x[i]) - shift) * scale;
+            y[i] = static_cast<T>((gamma ? t * F(gamma[i]) : t) + (beta ? F(beta[i]) : F()));
+        }
+    }
+    // Welford mean and sum of squared deviations in one read
+    static void layernorm(const T* x, T* y, size_t n, T eps, const T* gamma, const T* beta) {
+        F mean = F(), m2 = F();
+        for (size_t i = 0; i < n; ++i) {
+            F d = F(x[i]) - mean;
+            mean += d / F(i + 1);
+            m2 += d * (F(x[i]) - mean);
+        }
+        affine(x, y, n, mean, F(1) / std::sqrt(m2 / F(n) + F(eps)), gamma, beta);
+    }
+    static void rmsnorm(const T* x, T* y, size_t n, T eps, const T* gamma, const T* beta) {
+        F ms = F();
+        for (size_t i = 0; i < n; ++i) ms += F(x[i]) * F(x[i]);
+        affine(x, y, n, F(), F(1) / std::sqrt(ms / F(n) + F(eps)), gamma, beta);
+    }
+};
+
+#ifdef FT_ARCH_X86
+// ------------------------------
+// SSE4.2
+// ------------------------------
+struct Sse42F32 {
+    using T = float; using V = __m128;
+    static constexpr size_t W = 4;
+    static constexpr bool has_sqrt = true;
+    static constexpr bool has_div = true;
+    FT_SSE42 static V load(const T* p) { return _mm_loadu_ps(p); }
+    FT_SSE42 static void store(T* p, V v) { _mm_storeu_ps(p, v); }
+    FT_SSE42 static V set1(T s) { return _mm_set1_ps(s); }
+    FT_SSE42 static V fma(V a, V b, V c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    FT_SSE42 static V vsqrt(V a) { return _mm_sqrt_ps(a); }
+    // Math primitives, see FT_SIMD_MATH
+    using M = __m128;
+    static constexpr bool has_fma = false;
+    FT_SSE42 static M lt(V a, V b) { return _mm_cmplt_ps(a, b); }
+    FT_SSE42 static M le(V a, V b) { return _mm_cmple_ps(a, b); }
+    FT_SSE42 static M eq(V a, V b) { return _mm_cmpeq_ps(a, b); }
+    FT_SSE42 static M nan_mask(V a) { return _mm_cmpunord_ps(a, a); }
+    FT_SSE42 static M mor(M a, M b) { return _mm_or_ps(a, b); }
+    FT_SSE42 static bool any(M m) { return _mm_movemask_ps(m) != 0; }
+    FT_SSE42 static V select(M m, V a, V b) { return _mm_blendv_ps(b, a, m); }
+    FT_SSE42 static V band(V a, V b) { return _mm_and_ps(a, b); }
+    FT_SSE42 static V bor(V a, V b) { return _mm_or_ps(a, b); }
+    FT_SSE42 static V bxor(V a, V b) { return _mm_xor_ps(a, b); }
+    FT_SSE42 static V bandnot(V a, V b) { return _mm_andnot_ps(a, b); }
+    FT_SSE42 static V vround(V a) { return _mm_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    FT_SSE42 static V exponent(V a) { return _mm_cvtepi32_ps(_mm_srli_epi32(_mm_castps_si128(a), 23)); }
+    FT_SSE42 static V pow2n(V n) {
+        return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127)), 23));
+    }
+    template <OpKind K> FT_SSE42 static V apply(V a, V b) {
+        if constexpr (K == OpKind::Add) return _mm_add_ps(a, b);
+        else if constexpr (K == OpKind::Sub) return _mm_sub_ps(a, b);
+        else if constexpr (K == OpKind::Mul) return _mm_mul_ps(a, b);
+        else if constexpr (K == OpKind::Div) return _mm_div_ps(a, b);
+        else if constexpr (K == OpKind::Min) return _mm_min_ps(a, b);
+        else return _mm_max_ps(a, b);
+    }
+    FT_SIMD_KERNELS(FT_SSE42)
+    FT_SIMD_FLOAT(FT_SSE42)
+    FT_SIMD_MATH(FT_SSE42)
+};
+
+struct Sse42F64 {
+    using T = double; using V = __m128d;
+    static constexpr size_t W = 2;
+    static constexpr bool has_sqrt = true;
+    static constexpr bool has_div = true;
+    FT_SSE42 static V load(const T* p) { return _mm_loadu_pd(p); }
+    FT_SSE42 static void store(T* p, V v) { _mm_storeu_pd(p, v); }
+    FT_SSE42 static V set1(T s) { return _mm_set1_pd(s); }
+    FT_SSE42 static V fma(V a, V b, V c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+    FT_SSE42 static V vsqrt(V a) { return _mm_sqrt_pd(a); }
+    // Math primitives; int64 conversions go through the 2^52 magic
+    using M = __m128d;
+    static constexpr bool has_fma = false;
+    FT_SSE42 static M lt(V a, V b) { return _mm_cmplt_pd(a, b); }
+    FT_SSE42 static M le(V a, V b) { return _mm_cmple_pd(a, b); }
+    FT_SSE42 static M eq(V a, V b) { return _mm_cmpeq_pd(a, b); }
+    FT_SSE42 static M nan_mask(V a) { return _mm_cmpunord_pd(a, a); }
+    FT_SSE42 static M mor(M a, M b) { return _mm_or_pd(a, b); }
+    FT_SSE42 static bool any(M m) { return _mm_movemask_pd(m) != 0; }
+    FT_SSE42 static V select(M m, V a, V b) { return _mm_blendv_pd(b, a, m); }
+    FT_SSE42 static V band(V a, V b) { return _mm_and_pd(a, b); }
+    FT_SSE42 static V bor(V a, V b) { return _mm_or_pd(a, b); }
+    FT_SSE42 static V bxor(V a, V b) { return _mm_xor_pd(a, b); }
+    FT_SSE42 static V bandnot(V a, V b) { return _mm_andnot_pd(a, b); }
+    FT_SSE42 static V vround(V a) { return _mm_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    FT_SSE42 static V exponent(V a) {
+        __m128i e = _mm_or_si128(_mm_srli_epi64(_mm_castpd_si128(a), 52), _mm_set1_epi64x(0x4330000000000000ll));
+        return _mm_sub_pd(_mm_castsi128_pd(e), _mm_set1_pd(4503599627370496.0));
+    }
+    FT_SSE42 static V pow2n(V n) {
+        __m128i b = _mm_castpd_si128(_mm_add_pd(n, _mm_set1_pd(6755399441055744.0)));
+        return _mm_castsi128_pd(_mm_slli_epi64(_mm_add_epi64(b, _mm_set1_epi64x(1023)), 52));
+    }
+    template <OpKind K> FT_SSE42 static V apply(V a, V b) {
+        if constexpr (K == OpKind::Add) return _mm_add_pd(a, b);
+        else if constexpr (K == OpKind::Sub) return _mm_sub_pd(a, b);
+        else if constexpr (K == OpKind::Mul) return _mm_mul_pd(a, b);
+        else if constexpr (K == OpKind::Div) return _mm_div_pd(a, b);
+        else if constexpr (K == OpKind::Min) return _mm_min_pd(a, b);
+        else return _mm_max_pd(a, b);
+    }
+    FT_SIMD_KERNELS(FT_SSE42)
+    FT_SIMD_FLOAT(FT_SSE42)
+    FT_SIMD_MATH(FT_SSE42)
+};
+
+struct Sse42S32 {
+    using T = int32_t; using V = __m128i;
+    static constexpr size_t W = 4;
+    static constexpr bool has_sqrt = false;
+    static constexpr bool has_div = false;
+    FT_SSE42 static V load(const T* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    FT_SSE42 static void store(T* p, V v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    FT_SSE42 static V set1(T s) { return _mm_set1_epi32(s); }
+    FT_SSE42 static V fma(V a, V b, V c) { return _mm_add_epi32(_mm_mullo_epi32(a, b), c); }
+    template <OpKind K> FT_SSE42 static V apply(V a, V b) {
+        static_assert(K != OpKind::Div || has_div, "no vector division for this type, Div must take the scalar path");
+        if constexpr (K == OpKind::Add) return _mm_add_epi32(a, b);
+        else if constexpr (K == OpKind::Sub) return _mm_sub_epi32(a, b);
+        else if constexpr (K == OpKind::Mul) return _mm_mullo_epi32(a, b);
+        else if constexpr (K == OpKind::Min) return _mm_min_epi32(a, b);
+        else return _mm_max_epi32(a, b);
+    }
+    FT_SIMD_KERNELS(FT_SSE42)
+};
+
+// ------------------------------
+// AVX2 + FMA
+// ------------------------------
+struct Avx2F32 {
+    using T = float; using V = __m256;
+    static constexpr size_t W = 8;
+    static constexpr bool has_sqrt = true;
+    static constexpr bool has_div = true;
+    FT_AVX2 static V load(const T* p) { return _mm256_loadu_ps(p); }
+    FT_AVX2 static void store(T* p, V v) { _mm256_storeu_ps(p, v); }
+    FT_AVX2 static V set1(T s) { return _mm256_set1_ps(s); }
+    FT_AVX2 static V fma(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+    FT_AVX2 static V vsqrt(V a) { return _mm256_sqrt_ps(a); }
+    using M = __m256;
+    static constexpr bool has_fma = true;
+    FT_AVX2 static M lt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    FT_AVX2 static M le(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    FT_AVX2 static M eq(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    FT_AVX2 static M nan_mask(V a) { return _mm256_cmp_ps(a, a, _CMP_UNORD_Q); }
+    FT_AVX2 static M mor(M a, M b) { return _mm256_or_ps(a, b); }
+    FT_AVX2 static bool any(M m) { return _mm256_movemask_ps(m) != 0; }
+    FT_AVX2 static V select(M m, V a, V b) { return _mm256_blendv_ps(b, a, m); }
+    FT_AVX2 static V band(V a, V b) { return _mm256_and_ps(a, b); }
+    FT_AVX2 static V bor(V a, V b) { return _mm256_or_ps(a, b); }
+    FT_AVX2 static V bxor(V a, V b) { return _mm256_xor_ps(a, b); }
+    FT_AVX2 static V bandnot(V a, V b) { return _mm256_andnot_ps(a, b); }
+    FT_AVX2 static V vround(V a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    FT_AVX2 static V exponent(V a) { return _mm256_cvtepi32_ps(_mm256_srli_epi32(_mm256_castps_si256(a), 23)); }
+    FT_AVX2 static V pow2n(V n) {
+        return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23));
+    }
+    template <OpKind K> FT_AVX2 static V apply(V a, V b) {
+        if constexpr (K == OpKind::Add) return _mm256_add_ps(a, b);
+        else if constexpr (K == OpKind::Sub) return _mm256_sub_ps(a, b);
+        else if constexpr (K == OpKind::Mul) return _mm256_mul_ps(a, b);
+        else if constexpr (K == OpKind::Div) return _mm256_div_ps(a, b);
+        else if constexpr (K == OpKind::Min) return _mm256_min_ps(a, b);
+        else return _mm256_max_ps(a, b);
+    }
+    FT_SIMD_KERNELS(FT_AVX2)
+    FT_SIMD_FLOAT(FT_AVX2)
+    FT_SIMD_MATH(FT_AVX2)
+};
+
+struct Avx2F64 {
+    using T = double; using V = __m256d;
+    static constexpr size_t W = 4;
+    static constexpr bool has_sqrt = true;
+    static constexpr bool has_div = true;
+    FT_AVX2 static V load(const T* p) { return _mm256_loadu_pd(p); }
+    FT_AVX2 static void store(T* p, V v) { _mm256_storeu_pd(p, v); }
+    FT_AVX2 static V set1(T s) { return _mm256_set1_pd(s); }
+    FT_AVX2 static V fma(V a, V b, V c) { return _mm256_fmadd_pd(a, b, c); }
+    FT_AVX2 static V vsqrt(V a) { return _mm256_sqrt_pd(a); }
+    using M = __m256d;
+    static constexpr bool has_fma = true;
+    FT_AVX2 static M lt(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    FT_AVX2 static M le(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+    FT_AVX2 static M eq(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+    FT_AVX2 static M nan_mask(V a) { return _mm256_cmp_pd(a, a, _CMP_UNORD_Q); }
+    FT_AVX2 static M mor(M a, M b) { return _mm256_or_pd(a, b); }
+    FT_AVX2 static bool any(M m) { return _mm256_movemask_pd(m) != 0; }
+    FT_AVX2 static V select(M m, V a, V b) { return _mm256_blendv_pd(b, a, m); }
+    FT_AVX2 static V band(V a, V b) { return _mm256_and_pd(a, b); }
+    FT_AVX2 static V bor(V a, V b) { return _mm256_or_pd(a, b); }
+    FT_AVX2 static V bxor(V a, V b) { return _mm256_xor_pd(a, b); }
+    FT_AVX2 static V bandnot(V a, V b) { return _mm256_andnot_pd(a, b); }
+    FT_AVX2 static V vround(V a) { return _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    FT_AVX2 static V exponent(V a) {
+        __m256i e = _mm256_or_si256(_mm256_srli_epi64(_mm256_castpd_si256(a), 52), _mm256_set1_epi64x(0x4330000000000000ll));
+        return _mm256_sub_pd(_mm256_castsi256_pd(e), _mm256_set1_pd(4503599627370496.0));
+    }
+    FT_AVX2 static V pow2n(V n) {
+        __m256i b = _mm256_castpd_si256(_mm256_add_pd(n, _mm256_set1_pd(6755399441055744.0)));
+        return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(b, _mm256_set1_epi64x(1023)), 52));
+    }
+    template <OpKind K> FT_AVX2 static V apply(V a, V b) {
+        if constexpr (K == OpKind::Add) return _mm256_add_pd(a, b);
+        else if constexpr (K == OpKind::Sub) return _mm256_sub_pd(a, b);
+        else if constexpr (K == OpKind::Mul) return _mm256_mul_pd(a, b);
+        else if constexpr (K == OpKind::Div) return _mm256_div_pd(a, b);
+        else if constexpr (K == OpKind::Min) return _mm256_min_pd(a, b);
+        else return _mm256_max_pd(a, b);
+    }
+    FT_SIMD_KERNELS(FT_AVX2)
+    FT_SIMD_FLOAT(FT_AVX2)
+    FT_SIMD_MATH(FT_AVX2)
+};
+
+struct Avx2S32 {
+    using T = int32_t; using V = __m256i;
+    static constexpr size_t W = 8;
+    static constexpr bool has_sqrt = false;
+    static constexpr bool has_div = false;
+    FT_AVX2 static V load(const T* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    FT_AVX2 static void store(T* p, V v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    FT_AVX2 static V set1(T s) { return _mm256_set1_epi32(s); }
+    FT_AVX2 static V fma(V a, V b, V c) { return _mm256_add_epi32(_mm256_mullo_epi32(a, b), c); }
+    template <OpKind K> FT_AVX2 static V apply(V a, V b) {
+        static_assert(K != OpKind::Div || has_div, "no vector division for this type, Div must take the scalar path");
+        if constexpr (K == OpKind::Add) return _mm256_add_epi32(a, b);
+        else if constexpr (K == OpKind::Sub) return _mm256_sub_epi32(a, b);
+        else if constexpr (K == OpKind::Mul) return _mm256_mullo_epi32(a, b);
+        else if constexpr (K == OpKind::Min) return _mm256_min_epi32(a, b);
+        else return _mm256_max_epi32(a, b);
+    }
+    FT_SIMD_KERNELS(FT_AVX2)
+};
+
+// ------------------------------
+// AVX-512F
+// GCC's unmasked forms of several AVX-512 intrinsics pass an uninitialised
+// passthrough and trip -Wmaybe-uninitialized; the maskz forms with every
+// lane set compile to the same instruction.
+// ------------------------------
+struct Avx512F32 {
+    using T = float; using V = __m512;
+    static constexpr size_t W = 16;
+    static constexpr bool has_sqrt = true;
+    static constexpr bool has_div = true;
+    FT_AVX512 static V load(const T* p) { return _mm512_loadu_ps(p); }
+    FT_AVX512 static void store(T* p, V v) { _mm512_storeu_ps(p, v); }
+    FT_AVX512 static V set1(T s) { return _mm512_set1_ps(s); }
+    FT_AVX512 static V fma(V a, V b, V c) { return _mm512_fmadd_ps(a, b, c); }
+    FT_AVX512 static V vsqrt(V a) { return _mm512_maskz_sqrt_ps(__mmask16(-1), a); }
+    // AVX-512F has no float bitwise ops, they go through the integer ones
+    using M = __mmask16;
+    static constexpr bool has_fma = true;
+    FT_AVX512 static M lt(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+    FT_AVX512 static M le(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+    FT_AVX512 static M eq(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+    FT_AVX512 static M nan_mask(V a) { return _mm512_cmp_ps_mask(a, a, _CMP_UNORD_Q); }
+    FT_AVX512 static M mor(M a, M b) { return M(a | b); }
+    FT_AVX512 static bool any(M m) { return m != 0; }
+    FT_AVX512 static V select(M m, V a, V b) { return _mm512_mask_blend_ps(m, b, a); }
+    FT_AVX512 static V band(V a, V b) { return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a), _mm512_castps_si512(b))); }
+    FT_AVX512 static V bor(V a, V b) { return _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(a), _mm512_castps_si512(b))); }
+    FT_AVX512 static V bxor(V a, V b) { return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a), _mm512_castps_si512(b))); }
+    FT_AVX512 static V bandnot(V a, V b) { return _mm512_castsi512_ps(_mm512_maskz_andnot_epi32(__mmask16(-1), _mm512_castps_si512(a), _mm512_castps_si512(b))); }
+    FT_AVX512 static V vround(V a) { return _mm512_maskz_roundscale_ps(__mmask16(-1), a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    FT_AVX512 static V exponent(V a) { return _mm512_maskz_cvtepi32_ps(__mmask16(-1), _mm512_maskz_srli_epi32(__mmask16(-1), _mm512_castps_si512(a), 23)); }
+    FT_AVX512 static V pow2n(V n) {
+        return _mm512_castsi512_ps(_mm512_maskz_slli_epi32(__mmask16(-1),
+            _mm512_add_epi32(_mm512_maskz_cvtps_epi32(__mmask16(-1), n), _mm512_set1_epi32(127)), 23));
+    }
+    template <OpKind K> FT_AVX512 static V apply(V a, V b) {
+        if constexpr (K == OpKind::Add) return _mm512_add_ps(a, b);
+        else if constexpr (K == OpKind::Sub) return _mm512_sub_ps(a, b);
+        else if constexpr (K == OpKind::Mul) return _mm512_mul_ps(a, b);
+        else if constexpr (K == OpKind::Div) return _mm512_div_ps(a, b);
+        else if constexpr (K == OpKind::Min) return _mm512_maskz_min_ps(__mmask16(-1), a, b);
+        else return _mm512_maskz_max_ps(__mmask16(-1), a, b);
+    }
+    FT_SIMD_KERNELS(FT_AVX512)
+    FT_SIMD_FLOAT(FT_AVX512)
+    FT_SIMD_MATH(FT_AVX512)
+};
+
+struct Avx512F64 {
+    using T = double; using V = __m512d;
+    static constexpr size_t W = 8;
+    static constexpr bool has_sqrt = true;
+    static constexpr bool has_div = true;
+    FT_AVX512 static V load(const T* p) { return _mm512_loadu_pd(p); }
+    FT_AVX512 static void store(T* p, V v) { _mm512_storeu_pd(p, v); }
+    FT_AVX512 static V set1(T s) { return _mm512_set1_pd(s); }
+    FT_AVX512 static V fma(V a, V b, V c) { return _mm512_fmadd_pd(a, b, c); }
+    FT_AVX512 static V vsqrt(V a) { return _mm512_maskz_sqrt_pd(__mmask8(-1), a); }
+    using M = __mmask8;
+    static constexpr bool has_fma = true;
+    FT_AVX512 static M lt(V a, V b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+    FT_AVX512 static M le(V a, V b) { return _mm512_cmp_pd_mask(a, b, _CMP_LE_OQ); }
+    FT_AVX512 static M eq(V a, V b) { return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ); }
+    FT_AVX512 static M nan_mask(V a) { return _mm512_cmp_pd_mask(a, a, _CMP_UNORD_Q); }
+    FT_AVX512 static M mor(M a, M b) { return M(a | b); }
+    FT_AVX512 static bool any(M m) { return m != 0; }
+    FT_AVX512 static V select(M m, V a, V b) { return _mm512_mask_blend_pd(m, b, a); }
+    FT_AVX512 static V band(V a, V b) { return _mm512_castsi512_pd(_mm512_and_si512(_mm512_castpd_si512(a), _mm512_castpd_si512(b))); }
+    FT_AVX512 static V bor(V a, V b) { return _mm512_castsi512_pd(_mm512_or_si512(_mm512_castpd_si512(a), _mm512_castpd_si512(b))); }
+    FT_AVX512 static V bxor(V a, V b) { return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(a), _mm512_castpd_si512(b))); }
+    FT_AVX512 static V bandnot(V a, V b) { return _mm512_castsi512_pd(_mm512_maskz_andnot_epi64(__mmask8(-1), _mm512_castpd_si512(a), _mm512_castpd_si512(b))); }
+    FT_AVX512 static V vround(V a) { return _mm512_maskz_roundscale_pd(__mmask8(-1), a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    FT_AVX512 static V exponent(V a) {
+        __m512i e = _mm512_or_si512(_mm512_maskz_srli_epi64(__mmask8(-1), _mm512_castpd_si512(a), 52), _mm512_set1_epi64(0x4330000000000000ll));
+        return _mm512_sub_pd(_mm512_castsi512_pd(e), _mm512_set1_pd(4503599627370496.0));
+    }
+    FT_AVX512 static V pow2n(V n) {
+        __m512i b = _mm512_castpd_si512(_mm512_add_pd(n, _mm512_set1_pd(6755399441055744.0)));
+        return _mm512_castsi512_pd(_mm512_maskz_slli_epi64(__mmask8(-1), _mm512_add_epi64(b, _mm512_set1_epi64(1023)), 52));
+    }
+    template <OpKind K> FT_AVX512 static V apply(V a, V b) {
+        if constexpr (K == OpKind::Add) return _mm512_add_pd(a, b);
+        else if constexpr (K == OpKind::Sub) return _mm512_sub_pd(a, b);
+        else if constexpr (K == OpKind::Mul) return _mm512_mul_pd(a, b);
+        else if constexpr (K == OpKind::Div) return _mm512_div_pd(a, b);
+        else if constexpr (K == OpKind::Min) return _mm512_maskz_min_pd(__mmask8(-1), a, b);
+        else return _mm512_maskz_max_pd(__mmask8(-1), a, b);
+    }
+    FT_SIMD_KERNELS(FT_AVX512)
+    FT_SIMD_FLOAT(FT_AVX512)
+    FT_SIMD_MATH(FT_AVX512)
+};
+
+struct Avx512S32 {
+    using T = int32_t; using V = __m512i;
+    static constexpr size_t W = 16;
+    static constexpr bool has_sqrt = false;
+    static constexpr bool has_div = false;
+    FT_AVX512 static V load(const T* p) { return _mm512_loadu_si512(p); }
+    FT_AVX512 static void store(T* p, V v) { _mm512_storeu_si512(p, v); }
+    FT_AVX512 static V set1(T s) { return _mm512_set1_epi32(s); }
+    FT_AVX512 static V fma(V a, V b, V c) { return _mm512_add_epi32(_mm512_mullo_epi32(a, b), c); }
+    template <OpKind K> FT_AVX512 static V apply(V a, V b) {
+        static_assert(K != OpKind::Div || has_div, "no vector division for this type, Div must take the scalar path");
+        if constexpr (K == OpKind::Add) return _mm512_add_epi32(a, b);
+        else if constexpr (K == OpKind::Sub) return _mm512_sub_epi32(a, b);
+        else if constexpr (K == OpKind::Mul) return _mm512_mullo_epi32(a, b);
+        else if constexpr (K == OpKind::Min) return _mm512_maskz_min_epi32(__mmask16(-1), a, b);
+        else return _mm512_maskz_max_epi32(__mmask16(-1), a, b);
+    }
+    FT_SIMD_KERNELS(FT_AVX512)
+};
+#endif // FT_ARCH_X86
+
+#ifdef FT_ARCH_NEON
+// ------------------------------
+// NEON (baseline on ARM, no runtime attribute needed)
+// ------------------------------
+#define FT_NEON
+struct NeonF32 {
+    using T = float; using V = float32x4_t;
+    static constexpr size_t W = 4;
+#  if defined(__aarch64__)
+    static constexpr bool has_sqrt = true;
+    static constexpr bool has_div = true;
+#  else
+    static constexpr bool has_sqrt = false;
+    static constexpr bool has_div = false;
+#  endif
+    static V load(const T* p) { return vld1q_f32(p); }
+    static void store(T* p, V v) { vst1q_f32(p, v); }
+    static V set1(T s) { return vdupq_n_f32(s); }
+#  if defined(__aarch64__)
+    static V fma(V a, V b, V c) { return vfmaq_f32(c, a, b); }
+    static V vsqrt(V a) { return vsqrtq_f32(a); }
+#  else
+    static V fma(V a, V b, V c) { return vmlaq_f32(c, a, b); }
+#  endif
+#  if defined(__aarch64__)
+    using M = uint32x4_t;
+    static constexpr bool has_fma = true;
+    static M lt(V a, V b) { return vcltq_f32(a, b); }
+    static M le(V a, V b) { return vcleq_f32(a, b); }
+    static M eq(V a, V b) { return vceqq_f32(a, b); }
+    static M nan_mask(V a) { return vmvnq_u32(vceqq_f32(a, a)); }
+    static M mor(M a, M b) { return vorrq_u32(a, b); }
+    static bool any(M m) { return vmaxvq_u32(m) != 0; }
+    static V select(M m, V a, V b) { return vbslq_f32(m, a, b); }
+    static V band(V a, V b) { return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+    static V bor(V a, V b) { return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+    static V bxor(V a, V b) { return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+    static V bandnot(V a, V b) { return vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(b), vreinterpretq_u32_f32(a))); }
+    static V vround(V a) { return vrndnq_f32(a); }
+    static V exponent(V a) { return vcvtq_f32_u32(vshrq_n_u32(vreinterpretq_u32_f32(a), 23)); }
+    static V pow2n(V n) {
+        return vreinterpretq_f32_s32(vshlq_n_s32(vaddq_s32(vcvtnq_s32_f32(n), vdupq_n_s32(127)), 23));
+    }
+#  endif
+    template <OpKind K> static V apply(V a, V b) {
+        static_assert(K != OpKind::Div || has_div, "no vector division for this type, Div must take the scalar path");
+        if constexpr (K == OpKind::Add) return vaddq_f32(a, b);
+        else if constexpr (K == OpKind::Sub) return vsubq_f32(a, b);
+        else if constexpr (K == OpKind::Mul) return vmulq_f32(a, b);
+#  if defined(__aarch64__)
+        else if constexpr (K == OpKind::Div) return vdivq_f32(a, b);
+#  endif
+        // vminq/vmaxq propagate NaN; select so NaN yields b as in scalar_apply and x86
+        else if constexpr (K == OpKind::Min) return vbslq_f32(vcltq_f32(a, b), a, b);
+        else return vbslq_f32(vcgtq_f32(a, b), a, b);
+    }
+    FT_SIMD_KERNELS(FT_NEON)
+#  if defined(__aarch64__)
+    FT_SIMD_FLOAT(FT_NEON)
+    FT_SIMD_MATH(FT_NEON)
+#  endif
+};
+
+struct NeonS32 {
+    using T = int32_t; using V = int32x4_t;
+    static constexpr size_t W = 4;
+    static constexpr bool has_sqrt = false;
+    static constexpr bool has_div = false;
+    static V load(const T* p) { return vld1q_s32(p); }
+    static void store(T* p, V v) { vst1q_s32(p, v); }
+    static V set1(T s) { return vdupq_n_s32(s); }
+    static V fma(V a, V b, V c) { return vmlaq_s32(c, a, b); }
+    template <OpKind K> static V apply(V a, V b) {
+        static_assert(K != OpKind::Div || has_div, "no vector division for this type, Div must take the scalar path");
+        if constexpr (K == OpKind::Add) return vaddq_s32(a, b);
+        else if constexpr (K == OpKind::Sub) return vsubq_s32(a, b);
+        else if constexpr (K == OpKind::Mul) return vmulq_s32(a, b);
+        else if constexpr (K == OpKind::Min) return vminq_s32(a, b);
+        else return vmaxq_s32(a, b);
+    }
+    FT_SIMD_KERNELS(FT_NEON)
+};
+
+#  if defined(__aarch64__)
+struct NeonF64 {
+    using T = double; using V = float64x2_t;
+    static constexpr size_t W = 2;
+    static constexpr bool has_sqrt = true;
+    static constexpr bool has_div = true;
+    static V load(const T* p) { return vld1q_f64(p); }
+    static void store(T* p, V v) { vst1q_f64(p, v); }
+    static V set1(T s) { return vdupq_n_f64(s); }
+    static V fma(V a, V b, V c) { return vfmaq_f64(c, a, b); }
+    static V vsqrt(V a) { return vsqrtq_f64(a); }
+    using M = uint64x2_t;
+    static constexpr bool has_fma = true;
+    static M lt(V a, V b) { return vcltq_f64(a, b); }
+    static M le(V a, V b) { return vcleq_f64(a, b); }
+    static M eq(V a, V b) { return vceqq_f64(a, b); }
+    static M nan_mask(V a) { return vreinterpretq_u64_u32(vmvnq_u32(vreinterpretq_u32_u64(vceqq_f64(a, a)))); }
+    static M mor(M a, M b) { return vorrq_u64(a, b); }
+    static bool any(M m) { return vmaxvq_u32(vreinterpretq_u32_u64(m)) != 0; }
+    static V select(M m, V a, V b) { return vbslq_f64(m, a, b); }
+    static V band(V a, V b) { return vreinterpretq_f64_u64(vandq_u64(vreinterpretq_u64_f64(a), vreinterpretq_u64_f64(b))); }
+    static V bor(V a, V b) { return vreinterpretq_f64_u64(vorrq_u64(vreinterpretq_u64_f64(a), vreinterpretq_u64_f64(b))); }
+    static V bxor(V a, V b) { return vreinterpretq_f64_u64(veorq_u64(vreinterpretq_u64_f64(a), vreinterpretq_u64_f64(b))); }
+    static V bandnot(V a, V b) { return vreinterpretq_f64_u64(vbicq_u64(vreinterpretq_u64_f64(b), vreinterpretq_u64_f64(a))); }
+    static V vround(V a) { return vrndnq_f64(a); }
+    static V exponent(V a) { return vcvtq_f64_u64(vshrq_n_u64(vreinterpretq_u64_f64(a), 52)); }
+    static V pow2n(V n) {
+        return vreinterpretq_f64_s64(vshlq_n_s64(vaddq_s64(vcvtnq_s64_f64(n), vdupq_n_s64(1023)), 52));
+    }
+    template <OpKind K> static V apply(V a, V b) {
+        if constexpr (K == OpKind::Add) return vaddq_f64(a, b);
+        else if constexpr (K == OpKind::Sub) return vsubq_f64(a, b);
+        else if constexpr (K == OpKind::Mul) return vmulq_f64(a, b);
+        else if constexpr (K == OpKind::Div) return vdivq_f64(a, b);
+        // vminq/vmaxq propagate NaN; select so NaN yields b as in scalar_apply and x86
+        else if constexpr (K == OpKind::Min) return vbslq_f64(vcltq_f64(a, b), a, b);
+        else return vbslq_f64(vcgtq_f64(a, b), a, b);
+    }
+    FT_SIMD_KERNELS(FT_NEON)
+    FT_SIMD_FLOAT(FT_NEON)
+    FT_SIMD_MATH(FT_NEON)
+};
+#  endif
+#endif // FT_ARCH_NEON
+
+// ------------------------------
+// CPU feature detection
+// ------------------------------
+inline Isa detect_isa() {
+#if defined(FT_ARCH_X86) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return Isa::Avx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return Isa::Avx2;
+    if (__builtin_cpu_supports("sse4.2")) return Isa::Sse42;
+    return Isa::Scalar;
+#elif defined(FT_ARCH_X86)
+#  if defined(__AVX512F__)
+    return Isa::Avx512;
+#  elif defined(__AVX2__)
+    return Isa::Avx2;
+#  else
+    return Isa::Sse42;
+#  endif
+#elif defined(FT_ARCH_NEON)
+    return Isa::Neon;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+// Detected once. FT_SIMD=scalar|sse4.2|avx2|avx512|neon caps the choice,
+// which is handy for benchmarking one binary across backends.
+inline Isa active_isa() {
+    static const Isa isa = []() {
+        Isa best = detect_isa();
+        const char* env = std::getenv("FT_SIMD");
+        if (!env) return best;
+        for (Isa cap : { Isa::Scalar, Isa::Neon, Isa::Sse42, Isa::Avx2, Isa::Avx512 }) {
+            if (std::strcmp(env, isa_name(cap)) != 0) continue;
+            if (cap == Isa::Scalar) return cap;
+            if ((cap == Isa::Neon) != (best == Isa::Neon)) return best; // foreign ISA
+            return std::min(cap, best);
+        }
+        return best;
+    }();
+    return isa;
+}
+
+// ------------------------------
+// Dispatch table
+// ------------------------------
+template <typename T>
+struct KernelTable {
+    using Binary      = void (*)(const T*, const T*, T*, size_t);
+    using Scalar      = void (*)(const T*, T, T*, size_t);
+    using Fused       = void (*)(const T*, const T*, const T*, T*, size_t);
+    using FusedScalar = void (*)(const T*, T, T, T*, size_t);
+    using Unary       = void (*)(const T*, T*, size_t);
+    using Summary     = void (*)(const T*, size_t, T*);
+    using SqDev       = T (*)(const T*, size_t, T);
+    using Pow         = void (*)(const T*, T, T*, size_t);
+    using Row         = void (*)(const T*, T*, size_t);
+    using Norm        = void (*)(const T*, T*, size_t, T, const T*, const T*);
+
+    Binary binary[kBinaryOps];   // indexed by OpKind
+    Scalar scalar[kBinaryOps];   // a op s, scalar broadcast
+    Fused fma;                   // a * b + c
+    FusedScalar fma_scalar;      // a * s + t
+    Unary sqrt;
+    Summary summary;             // { sum, min, max } in one read
+    SqDev sqdev;                 // sum of squared deviations, floating point
+    Unary exp, log, sin, cos, tanh, sigmoid, gelu;
+    Pow pow;                     // a ^ p, scalar exponent
+    Row softmax, log_softmax;    // over one contiguous row
+    Norm layernorm, rmsnorm;     // (x, y, n, eps, gamma, beta), gamma/beta may be null
+    Isa isa = Isa::Scalar;
+};
+
+// Vector math comes with the floating-point kernels (FT_SIMD_MATH is
+// expanded next to FT_SIMD_FLOAT), libm everywhere else
+template <typename T, typename Tr>
+void fill_math(KernelTable<T>& t) {
+    using Mt = typename std::conditional<Tr::has_sqrt, Tr, Generic<T>>::type;
+    t.exp = &Mt::exp;
+    t.log = &Mt::log;
+    t.sin = &Mt::sin;
+    t.cos = &Mt::cos;
+    t.tanh = &Mt::tanh;
+    t.sigmoid = &Mt::sigmoid;
+    t.gelu = &Mt::gelu;
+    t.pow = &Mt::pow;
+    t.softmax = &Mt::softmax;
+    t.log_softmax = &Mt::log_softmax;
+    t.layernorm = &Mt::layernorm;
+    t.rmsnorm = &Mt::rmsnorm;
+}
+
+template <typename T, typename Tr>
+KernelTable<T> make_table(Isa isa) {
+    KernelTable<T> t;
+    t.binary[0] = &Tr::template binary<OpKind::Add>;
+    t.binary[1] = &Tr::template binary<OpKind::Sub>;
+    t.binary[2] = &Tr::template binary<OpKind::Mul>;
+    t.binary[4] = &Tr::template binary<OpKind::Min>;
+    t.binary[5] = &Tr::template binary<OpKind::Max>;
+    t.scalar[0] = &Tr::template scalar<OpKind::Add>;
+    t.scalar[1] = &Tr::template scalar<OpKind::Sub>;
+    t.scalar[2] = &Tr::template scalar<OpKind::Mul>;
+    t.scalar[4] = &Tr::template scalar<OpKind::Min>;
+    t.scalar[5] = &Tr::template scalar<OpKind::Max>;
+    if constexpr (Tr::has_div) {
+        t.binary[3] = &Tr::template binary<OpKind::Div>;
+        t.scalar[3] = &Tr::template scalar<OpKind::Div>;
+    } else {
+        t.binary[3] = &Generic<T>::template binary<OpKind::Div>;
+        t.scalar[3] = &Generic<T>::template scalar<OpKind::Div>;
+    }
+    t.fma = &Tr::fused;
+    t.fma_scalar = &Tr::fused_scalar;
+    t.summary = &Tr::summary;
+    if constexpr (Tr::has_sqrt) {
+        t.sqrt = &Tr::root;
+        t.sqdev = &Tr::sqdev;
+    } else {
+        t.sqrt = &Generic<T>::root;
+        t.sqdev = &Generic<T>::sqdev;
+    }
+    fill_math<T, Tr>(t);
+    t.isa = isa;
+    return t;
+}
+
+template <typename T>
+KernelTable<T> select_table(Isa isa) {
+    (void)isa;
+#ifdef FT_ARCH_X86
+    if constexpr (std::is_same<T, float>::value) {
+        if (isa == Isa::Avx512) return make_table<T, Avx512F32>(isa);
+        if (isa == Isa::Avx2)   return make_table<T, Avx2F32>(isa);
+        if (isa == Isa::Sse42)  return make_table<T, Sse42F32>(isa);
+    } else if constexpr (std::is_same<T, double>::value) {
+        if (isa == Isa::Avx512) return make_table<T, Avx512F64>(isa);
+        if (isa == Isa::Avx2)   return make_table<T, Avx2F64>(isa);
+        if (isa == Isa::Sse42)  return make_table<T, Sse42F64>(isa);
+    } else if constexpr (std::is_same<T, int32_t>::value) {
+        if (isa == Isa::Avx512) return make_table<T, Avx512S32>(isa);
+        if (isa == Isa::Avx2)   return make_table<T, Avx2S32>(isa);
+        if (isa == Isa::Sse42)  return make_table<T, Sse42S32>(isa);
+    }
+#endif
+#ifdef FT_ARCH_NEON
+    if (isa == Isa::Neon) {
+        if constexpr (std::is_same<T, float>::value) return make_table<T, NeonF32>(isa);
+        else if constexpr (std::is_same<T, int32_t>::value) return make_table<T, NeonS32>(isa);
+#  if defined(__aarch64__)
+        else if constexpr (std::is_same<T, double>::value) return make_table<T, NeonF64>(isa);
+#  endif
+    }
+#endif
+    return make_table<T, Generic<T>>(Isa::Scalar);
+}
+
+// Kernels for T on this host, chosen on first use
+template <typename T>
+const KernelTable<T>& kernels() {
+    static const KernelTable<T> table = select_table<T>(active_isa());
+    return table;
+}
+
+} // namespace simd
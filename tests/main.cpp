@@ -0,0 +1,21 @@
+#include "testing.hpp"
+
+// fasttensor_tests [suite...]: runs every case, or those of the given suites
+int main(int argc, char** argv) {
+    std::vector<std::string> suites(argv + 1, argv + argc);
+    size_t run = 0, failed = 0;
+    for (auto& c : ft_test::registry()) {
+        if (!suites.empty() && std::find(suites.begin(), suites.end(), c.suite) == suites.end()) continue;
+        ++run;
+        try {
+            c.fn();
+            std::cout << "[ OK ] " << c.suite << "." << c.name << "\n";
+        } catch (const std::exception& e) {
+            ++failed;
+            std::cout << "[FAIL] " << c.suite << "." << c.name << ": " << e.what() << "\n";
+        }
+    }
+    std::cout << run - failed << "/" << run << " passed (" << simd::isa_name(simd::active_isa())
+              << ", " << Executor::global().num_threads() << " threads)\n";
+    return run == 0 || failed ? 1 : 0;
+}
@@ -0,0 +1,88 @@
+#include "testing.hpp"
+#include <cstdio>
+
+// Per-process file name, ctest may run suites in parallel
+static std::string temp_path() {
+    static std::string p = "ft_test_" + std::to_string(std::random_device{}()) + ".fta";
+    return p;
+}
+
+struct TempFile {
+    std::string path = temp_path();
+    ~TempFile() { std::remove(path.c_str()); }
+};
+
+FT_TEST(archive, round_trip) {
+    TempFile tmp;
+    auto a = Tensor<float>::random(-1.f, 1.f, { 3, 5, 7 });
+    auto at = a.transpose({ 2, 0, 1 });
+    auto as = a.slice(1, 1, 5, 2);
+    auto ab = Tensor<float>::random(-1.f, 1.f, { 1, 4 }).expand({ 3, 4 });
+    auto d = Tensor<double>::random(-1.0, 1.0, { 10 });
+    auto i8 = Tensor<int8_t>::random(-100, 100, { 17 });
+    auto wq = QTensor<int8_t>::quantize(Tensor<float>::random(-1.f, 1.f, { 8, 16 }), true, 0);
+    HalfTensor h(Tensor<float>::random(-1.f, 1.f, { 4, 16 }));
+    {
+        ArchiveWriter w(tmp.path);
+        w.add("a", a); w.add("at", at); w.add("as", as); w.add("ab", ab);
+        w.add("d", d); w.add("i8", i8); w.add("wq", wq); w.add("h", h);
+        w.add("empty", Tensor<float>({ 0, 3 }));
+        CHECK_THROWS(w.add("a", a));
+    }
+    TensorArchive ar(tmp.path);
+    CHECK(ar.size() == 9 && ar.contains("wq") && !ar.contains("b"));
+    for (auto& e : ar.entries()) CHECK(e.offset % 64 == 0);
+    CHECK(ar.get<float>("a").to_vector() == a.to_vector());
+    auto rat = ar.get<float>("at");
+    CHECK(rat.to_vector() == at.to_vector() && rat.shape() == at.shape() && !rat.is_contiguous());
+    CHECK(ar.get<float>("as").to_vector() == as.to_vector());
+    CHECK(ar.get<float>("ab").to_vector() == ab.to_vector());
+    CHECK(ar.get<double>("d").to_vector() == d.to_vector());
+    CHECK(ar.get<int8_t>("i8").to_vector() == i8.to_vector());
+    auto rq = ar.get_quantized<int8_t>("wq");
+    CHECK(rq.to_vector() == wq.to_vector() && rq.qparams().scale == wq.qparams().scale && rq.qparams().axis == 0);
+    CHECK(ar.get_half("h").to_float().to_vector() == h.to_float().to_vector());
+    CHECK(ar.get<float>("empty").shape() == (std::vector<size_t>{ 0, 3 }));
+    CHECK_THROWS(ar.get<double>("a"));
+    CHECK_THROWS(ar.get<int8_t>("wq"));
+    CHECK_THROWS(ar.get<float>("missing"));
+}
+
+FT_TEST(archive, mapped_tensors_are_read_only_views) {
+    TempFile tmp;
+    auto a = Tensor<float>::random(-1.f, 1.f, { 64, 33 });
+    a.save(tmp.path);
+    Tensor<float> r = Tensor<float>::load(tmp.path);   // archive object already gone
+    CHECK(!r.is_writable() && r.to_vector() == a.to_vector());
+    Tensor<float> keep = r;
+    r.add(1.f).evaluate();
+    CHECK(r.is_writable() && keep.to_vector() == a.to_vector());
+    CHECK_NEAR(r.sum(), a.sum() + 64 * 33, 1e-3);
+    auto x = Tensor<float>::random(-1.f, 1.f, { 2, 33 });
+    CHECK(x.linear(keep).to_vector() == x.linear(a).to_vector());
+}
+
+FT_TEST(archive, rejects_bad_files) {
+    TempFile tmp;
+    auto a = Tensor<float>::ones({ 100 });
+    a.save(tmp.path);
+    {
+        std::FILE* f = std::fopen(tmp.path.c_str(), "r+b");
+        std::fputc('X', f);
+        std::fclose(f);
+    }
+    CHECK_THROWS(TensorArchive(tmp.path));
+    a.save(tmp.path);
+    {
+        // drop the directory tail
+        std::FILE* f = std::fopen(tmp.path.c_str(), "rb");
+        std::vector<char> bytes(1 << 16);
+        bytes.resize(std::fread(bytes.data(), 1, bytes.size(), f));
+        std::fclose(f);
+        f = std::fopen(tmp.path.c_str(), "wb");
+        std::fwrite(bytes.data(), 1, bytes.size() - 3, f);
+        std::fclose(f);
+    }
+    CHECK_THROWS(TensorArchive(tmp.path));
+    CHECK_THROWS(TensorArchive("does/not/exist.fta"));
+}
@@ -0,0 +1,97 @@
+#include "testing.hpp"
+
+FT_TEST(executor, parallel_for_covers_range_once) {
+    Executor& ex = Executor::global();
+    for (int rep = 0; rep < 20; ++rep) {
+        std::vector<int> hit(100000, 0);
+        ex.parallel_for(0, hit.size(), 64, [&](size_t b, size_t e) { for (size_t i = b; i < e; ++i) hit[i]++; });
+        CHECK(std::all_of(hit.begin(), hit.end(), [](int h) { return h == 1; }));
+    }
+}
+
+FT_TEST(executor, deterministic_reduce) {
+    Executor& ex = Executor::global();
+    double s = ex.parallel_reduce(0, 1000000, 4096, 0.0,
+        [](size_t b, size_t e) { double a = 0; for (size_t i = b; i < e; ++i) a += double(i); return a; },
+        [](double a, double b) { return a + b; });
+    CHECK(s == 999999.0 * 1000000 / 2);
+}
+
+FT_TEST(executor, nested_and_concurrent_callers) {
+    Executor& ex = Executor::global();
+    std::atomic<long> tot{ 0 };
+    ex.parallel_for(0, 64, 1, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i)
+            ex.parallel_for(0, 50000, 1000, [&](size_t b2, size_t e2) { tot += long(e2 - b2); });
+    });
+    CHECK(tot == 64 * 50000);
+
+    std::atomic<int> bad{ 0 };
+    std::vector<std::thread> ts;
+    for (int t = 0; t < 4; ++t)
+        ts.emplace_back([&] {
+            for (int r = 0; r < 20; ++r) {
+                std::atomic<size_t> c{ 0 };
+                ex.parallel_for(0, 200000, 500, [&](size_t b, size_t e) { c += e - b; });
+                if (c != 200000) ++bad;
+            }
+        });
+    for (auto& t : ts) t.join();
+    CHECK(bad == 0);
+}
+
+FT_TEST(executor, second_caller_is_split) {
+    ExecutorConfig cfg;
+    cfg.threads = 4;
+    cfg.serial_cutoff = 0;
+    Executor ex(cfg);
+    std::atomic<bool> go{ false };
+    std::thread holder([&] { ex.parallel_for(0, 2, 1, [&](size_t, size_t) { while (!go) std::this_thread::yield(); }); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::atomic<int> pieces{ 0 };
+    ex.parallel_for(0, 1 << 16, 256, [&](size_t, size_t) { ++pieces; });
+    go = true;
+    holder.join();
+    CHECK(pieces > 1);
+}
+
+FT_TEST(executor, exceptions_propagate) {
+    CHECK_THROWS(Executor::global().parallel_for(0, 1000000, 100, [](size_t, size_t e) {
+        if (e > 5000) throw std::runtime_error("boom");
+    }));
+}
+
+#if defined(__linux__)
+FT_TEST(executor, pins_workers_not_caller) {
+    cpu_set_t before, after;
+    CPU_ZERO(&before);
+    sched_getaffinity(0, sizeof(before), &before);
+    int cpu = 0;
+    while (!CPU_ISSET(cpu, &before)) ++cpu;
+    ExecutorConfig cfg;
+    cfg.threads = 3;
+    cfg.cpus = { cpu };
+    cfg.serial_cutoff = 0;
+    Executor ex(cfg);
+    std::atomic<int> off{ 0 };
+    ex.parallel_for(0, 4096, 16, [&](size_t, size_t) {
+        if (ex.current_worker() != 0 && sched_getcpu() != cpu) ++off;
+    });
+    CHECK(off == 0);
+    CPU_ZERO(&after);
+    sched_getaffinity(0, sizeof(after), &after);
+    CHECK(CPU_EQUAL(&before, &after));
+}
+#endif
+
+FT_TEST(executor, reconfigure) {
+    Executor& ex = Executor::global();
+    ExecutorConfig old = ex.settings();
+    ExecutorConfig cfg;
+    cfg.threads = 3;
+    ex.configure(cfg);
+    CHECK(ex.num_threads() == 3);
+    auto a = Tensor<float>::fill({ 300000 }, 2.f), b = Tensor<float>::fill({ 300000 }, 3.f);
+    CHECK((a * b).evaluate().max() == 6.f);
+    ex.configure(old);
+}
@@ -0,0 +1,82 @@
+#include "testing.hpp"
+
+// Reference product of 2-D tensors, accumulated in double
+template <typename T>
+static std::vector<T> naive(const Tensor<T>& a, const Tensor<T>& b) {
+    size_t M = a.shape()[0], K = a.shape()[1], N = b.shape()[1];
+    std::vector<T> c(M * N);
+    for (size_t i = 0; i < M; ++i)
+        for (size_t j = 0; j < N; ++j) {
+            double s = 0;
+            for (size_t p = 0; p < K; ++p) s += double(a.at({ i, p })) * double(b.at({ p, j }));
+            c[i * N + j] = T(s);
+        }
+    return c;
+}
+
+template <typename T>
+static void sweep(double tol) {
+    const size_t dims[] = { 1, 2, 3, 7, 16, 17, 31, 97, 130 };
+    for (size_t M : dims)
+        for (size_t N : dims)
+            for (size_t K : { 1, 4, 33, 257 }) {
+                if (M * N * K > 1000000) continue;
+                auto a = Tensor<T>::random(T(-3), T(3), { M, K });
+                auto b = Tensor<T>::random(T(-3), T(3), { K, N });
+                CHECK_CLOSE(a.matmul(b).to_vector(), naive(a, b), tol);
+                auto at = Tensor<T>::random(T(-3), T(3), { K, M }).transpose();
+                auto bt = Tensor<T>::random(T(-3), T(3), { N, K }).transpose();
+                CHECK_CLOSE(at.matmul(bt).to_vector(), naive(at, bt), tol);
+            }
+}
+
+FT_TEST(gemm, sweep_float) { sweep<float>(1e-4); }
+FT_TEST(gemm, sweep_double) { sweep<double>(1e-10); }
+FT_TEST(gemm, sweep_int) { sweep<int>(0); }
+
+FT_TEST(gemm, vectors_and_empty) {
+    auto z = Tensor<float>::ones({ 3, 0 }).matmul(Tensor<float>::ones({ 0, 4 }));
+    CHECK(z.shape() == (std::vector<size_t>{ 3, 4 }) && z.sum() == 0);
+    auto v = Tensor<double>::random(-1, 1, { 7 });
+    auto m = Tensor<double>::random(-1, 1, { 7, 5 });
+    auto r = v.matmul(m);
+    CHECK(r.shape() == (std::vector<size_t>{ 5 }));
+    CHECK_CLOSE(r.to_vector(), naive(v.reshaped({ 1, 7 }), m), 1e-12);
+    auto m2 = Tensor<double>::random(-1, 1, { 5, 7 });
+    CHECK_CLOSE(m2.matmul(v).to_vector(), naive(m2, v.reshaped({ 7, 1 })), 1e-12);
+    auto s = v.matmul(v);
+    CHECK(s.shape().empty());
+    CHECK_NEAR(s.to_vector()[0], v.dot(v), 1e-12);
+    CHECK(Tensor<float>::ones({ 100000 }).dot(Tensor<float>::ones({ 100000 })) == 100000.f);
+}
+
+FT_TEST(gemm, batch_broadcast) {
+    auto A = Tensor<float>::random(-1, 1, { 2, 1, 9, 11 });
+    auto B = Tensor<float>::random(-1, 1, { 3, 11, 6 });
+    auto C = A.matmul(B);
+    CHECK(C.shape() == (std::vector<size_t>{ 2, 3, 9, 6 }));
+    for (size_t i = 0; i < 2; ++i)
+        for (size_t j = 0; j < 3; ++j) {
+            auto ai = A.slice(0, i, i + 1).reshaped({ 9, 11 });
+            auto bj = B.slice(0, j, j + 1).reshaped({ 11, 6 });
+            auto ci = C.slice(0, i, i + 1).slice(1, j, j + 1).reshaped({ 9, 6 });
+            CHECK_CLOSE(ci.to_vector(), naive(ai, bj), 1e-5);
+        }
+    CHECK(Tensor<float>::random(-1, 1, { 4, 9, 11 }).bmm(B.slice(0, 0, 1)).shape() == (std::vector<size_t>{ 4, 9, 6 }));
+    CHECK_THROWS(A.reshaped({ 18, 11 }).bmm(B));
+    CHECK_THROWS(A.matmul(A));
+}
+
+FT_TEST(gemm, linear_epilogue) {
+    for (size_t batch : { 1, 5, 70 })
+        for (Activation act : { Activation::None, Activation::Relu, Activation::Sigmoid, Activation::Tanh, Activation::Gelu }) {
+            auto x = Tensor<float>::random(-1, 1, { batch, 40 });
+            auto W = Tensor<float>::random(-1, 1, { 23, 40 });
+            auto bias = Tensor<float>::random(-1, 1, { 23 });
+            auto ref = naive(x, W.transpose());
+            auto bv = bias.to_vector();
+            for (size_t i = 0; i < batch; ++i)
+                for (size_t j = 0; j < 23; ++j) ref[i * 23 + j] = Gemm<float>::activate(ref[i * 23 + j] + bv[j], act);
+            CHECK_CLOSE(x.linear(W, bias, act).to_vector(), ref, 1e-4);
+        }
+}
@@ -0,0 +1,82 @@
+#include "testing.hpp"
+
+template <typename T>
+static void binary_ops() {
+    for (size_t n : { 1, 7, 33, 5000 }) {
+        auto a = Tensor<T>::fill({ n }, T(6)), b = Tensor<T>::fill({ n }, T(3)), c = Tensor<T>::fill({ n }, T(2));
+        CHECK((a - b).evaluate().sum() == T(3 * n));
+        CHECK((a * b).evaluate().sum() == T(18 * n));
+        CHECK((a / b).evaluate().sum() == T(2 * n));
+        Tensor<T> m = a;
+        CHECK(m.minimum(b).evaluate().max() == T(3));
+        Tensor<T> f = a;
+        CHECK(f.fma(b, c).evaluate().min() == T(20));
+        Tensor<T> s = a;
+        CHECK(s.fma(T(2), T(1)).sub(T(1)).evaluate().max() == T(12));
+        CHECK((a * Tensor<T>::fill({ 1 }, T(2))).evaluate().sum() == T(12 * n));
+    }
+    auto x = Tensor<T>::fill({ 2, 3 }, T(1)), y = Tensor<T>::fill({ 3 }, T(2));
+    CHECK((x + y).evaluate().sum() == T(18));
+    auto w = (y + x).evaluate();
+    CHECK(w.sum() == T(18) && w.shape() == (std::vector<size_t>{ 2, 3 }));
+}
+
+FT_TEST(lazy, binary_float) { binary_ops<float>(); }
+FT_TEST(lazy, binary_double) { binary_ops<double>(); }
+FT_TEST(lazy, binary_int) { binary_ops<int>(); }
+FT_TEST(lazy, binary_long) { binary_ops<long>(); }
+
+template <typename T>
+static void chains() {
+    for (size_t n : { 1, 7, 300, 5000 }) {
+        auto a = Tensor<T>::fill({ n }, T(6)), b = Tensor<T>::fill({ n }, T(3)), c = Tensor<T>::fill({ n }, T(4));
+        CHECK_NEAR(((a + b) * c.sqrt()).evaluate().sum(), 18.0 * n, 1e-5);
+        Tensor<T> c2 = Tensor<T>::fill({ n }, T(4));
+        CHECK_NEAR((a * (b - c2.pow(T(2)))).evaluate().sum(), -78.0 * n, 1e-5);
+        Tensor<T> d = a;
+        CHECK_NEAR(d.sub(b).mul(a + b).evaluate().sum(), 27.0 * n, 1e-5);
+        Tensor<T> e = a;
+        CHECK_NEAR(e.apply(b, [](T x, T y) { return x * y + 1; }).evaluate().sum(), 19.0 * n, 1e-5);
+        Tensor<T> g = a;
+        CHECK_NEAR(g.apply(b + Tensor<T>::fill({ n }, T(4)), [](T x, T y) { return x - y; }).evaluate().sum(), -1.0 * n, 1e-5);
+    }
+    auto x = Tensor<T>::fill({ 2, 3 }, T(1)), y = Tensor<T>::fill({ 3 }, T(2));
+    CHECK_NEAR((x + (y * y)).evaluate().sum(), 30.0, 1e-6);
+    auto y2 = Tensor<T>::fill({ 3 }, T(2));
+    CHECK_NEAR((x * (y2 + y2)).evaluate().sum(), 24.0, 1e-6);
+}
+
+FT_TEST(lazy, chains_float) { chains<float>(); }
+FT_TEST(lazy, chains_double) { chains<double>(); }
+FT_TEST(lazy, chains_int) { chains<int>(); }
+
+FT_TEST(lazy, in_place_chain_sees_own_updates) {
+    auto u = Tensor<float>::fill({ 1000 }, 1.f);
+    u.add(u).mul(u).evaluate();
+    CHECK(u.max() == 4.f && u.min() == 4.f);
+}
+
+FT_TEST(lazy, scalar_core_broadcasts) {
+    auto sc = Tensor<float>::fill({ 1 }, 3.f);
+    sc.add(Tensor<float>::ones({ 2, 3 })).evaluate();
+    CHECK(sc.sum() == 24.f && sc.shape() == (std::vector<size_t>{ 2, 3 }));
+}
+
+FT_TEST(lazy, large_parallel_chain) {
+    auto a = Tensor<float>::fill({ 300000 }, 2.f), b = Tensor<float>::fill({ 300000 }, 3.f);
+    auto r = (a * b + a).evaluate();
+    CHECK(r.max() == 8.f && r.min() == 8.f);
+}
+
+FT_TEST(lazy, empty_core_is_a_no_op) {
+    Tensor<float> t;
+    t.add(1.f).evaluate();
+    Tensor<float> u;
+    u.sqrt().evaluate();
+    CHECK(t.to_vector().empty() && u.to_vector().empty());
+}
+
+FT_TEST(lazy, incompatible_shapes_throw) {
+    auto a = Tensor<float>::ones({ 2, 3 }), b = Tensor<float>::ones({ 4 });
+    CHECK_THROWS((a + b).evaluate());
+}
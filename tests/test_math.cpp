@@ -0,0 +1,303 @@
+#include "testing.hpp"
+#include <random>
+
+// Error of got in ulps of T against a long double reference; subnormal
+// references are not counted
+template <typename T>
+static double ulp_error(T got, long double ref) {
+    if (std::isnan(ref)) return std::isnan(got) ? 0 : 1e9;
+    if (std::isinf(T(ref))) return got == T(ref) ? 0 : 1e9;
+    if (std::abs(ref) < std::numeric_limits<T>::min()) return 0;
+    int e;
+    std::frexp(ref, &e);
+    return double(std::abs((long double)got - ref) / std::ldexp(1.0L, e - std::numeric_limits<T>::digits));
+}
+
+// Every kernel table up to the active one: scalar, then each vector ISA
+template <typename T>
+static std::vector<simd::KernelTable<T>> tables() {
+    std::vector<simd::KernelTable<T>> r;
+    for (auto isa : { simd::Isa::Scalar, simd::Isa::Neon, simd::Isa::Sse42, simd::Isa::Avx2, simd::Isa::Avx512 }) {
+        if (isa > simd::kernels<T>().isa) break;
+        auto t = simd::select_table<T>(isa);
+        if (t.isa == isa) r.push_back(t);
+    }
+    return r;
+}
+
+template <typename T, typename Gen, typename Ref>
+static void check_ulp(const simd::KernelTable<T>& t, const char* what, void (*k)(const T*, T*, size_t),
+                      Gen gen, double bound, Ref ref) {
+    std::mt19937_64 g(42);
+    std::vector<T> x(20000), y(x.size());
+    for (auto& v : x) v = T(gen(g));
+    k(x.data(), y.data(), x.size());
+    for (size_t i = 0; i < x.size(); ++i) {
+        double u = ulp_error(y[i], ref((long double)x[i]));
+        if (u > bound) {
+            std::ostringstream os;
+            os << simd::isa_name(t.isa) << " " << what << "(" << double(x[i]) << ") = " << double(y[i])
+               << ", " << u << " ulp";
+            ft_test::fail(__FILE__, __LINE__, os.str());
+        }
+    }
+}
+
+static std::function<double(std::mt19937_64&)> uniform(double lo, double hi) {
+    return [lo, hi](std::mt19937_64& g) { return std::uniform_real_distribution<double>(lo, hi)(g); };
+}
+
+// The bounds documented in vmath.tpp
+template <typename T>
+static void ulp_bounds() {
+    const bool f = sizeof(T) == 4;
+    const double emin = f ? -104 : -746, emax = f ? 89 : 710;
+    const double trig = f ? 8192 : 1e6, gmax = f ? 14 : 39;
+    const int lmin = std::numeric_limits<T>::min_exponent - 1, lmax = std::numeric_limits<T>::max_exponent - 1;
+    auto mag = [=](std::mt19937_64& g) {
+        return std::ldexp(std::uniform_real_distribution<double>(1, 2)(g), int(g() % (lmax - lmin)) + lmin);
+    };
+    for (const auto& t : tables<T>()) {
+        // libm's float tanh and the float sigmoid formula reach 2.3 ulp
+        const double libm = t.isa == simd::Isa::Scalar ? 1 : 0;
+        check_ulp(t, "exp", t.exp, uniform(emin, emax), 1, [](long double x) { return std::exp(x); });
+        check_ulp(t, "exp", t.exp, uniform(-1, 1), 1, [](long double x) { return std::exp(x); });
+        check_ulp(t, "log", t.log, mag, 1, [](long double x) { return std::log(x); });
+        check_ulp(t, "log", t.log, uniform(0.5, 2), 1, [](long double x) { return std::log(x); });
+        check_ulp(t, "sin", t.sin, uniform(-trig, trig), f ? 4 : 3, [](long double x) { return std::sin(x); });
+        check_ulp(t, "cos", t.cos, uniform(-trig, trig), f ? 4 : 3, [](long double x) { return std::cos(x); });
+        check_ulp(t, "sin", t.sin, uniform(-10, 10), 1.5, [](long double x) { return std::sin(x); });
+        check_ulp(t, "cos", t.cos, uniform(-10, 10), 1.5, [](long double x) { return std::cos(x); });
+        check_ulp(t, "tanh", t.tanh, uniform(-20, 20), 2 + libm, [](long double x) { return std::tanh(x); });
+        check_ulp(t, "sigmoid", t.sigmoid, uniform(emin + 1, -emin), 3,
+                  [](long double x) { return 1 / (1 + std::exp(-x)); });
+        auto gelu = [](long double x) { return 0.5L * x * std::erfc(-x * 0.707106781186547524401L); };
+        check_ulp(t, "gelu", t.gelu, uniform(0, gmax), 2, gelu);
+        check_ulp(t, "gelu", t.gelu, uniform(-gmax, 0), f ? 16 : 10, gelu);
+
+        std::mt19937_64 g(7);
+        std::vector<T> x(4000), y(x.size());
+        for (double p : { -91.0, -9.3377, -2.0, -0.5, 0.5, 1.7676, 3.0, 5.0, 88.379 }) {
+            bool odd = p == std::round(p);
+            for (auto& v : x) {
+                v = T(std::exp(std::uniform_real_distribution<double>(-7, 7)(g)));
+                if (odd && (g() & 1)) v = -v;
+            }
+            t.pow(x.data(), T(p), y.data(), x.size());
+            for (size_t i = 0; i < x.size(); ++i) {
+                long double ref = std::pow((long double)x[i], (long double)T(p));
+                if (std::abs(std::log(std::abs((long double)x[i])) * p) > 64) continue;
+                if (ulp_error(y[i], ref) > 3) {
+                    std::ostringstream os;
+                    os << simd::isa_name(t.isa) << " pow(" << double(x[i]) << ", " << p << ") = " << double(y[i]);
+                    ft_test::fail(__FILE__, __LINE__, os.str());
+                }
+            }
+        }
+    }
+}
+
+FT_TEST(math, ulp_float) { ulp_bounds<float>(); }
+FT_TEST(math, ulp_double) { ulp_bounds<double>(); }
+
+template <typename T>
+static void special_values() {
+    const T inf = std::numeric_limits<T>::infinity(), nan = std::numeric_limits<T>::quiet_NaN();
+    const T tiny = std::numeric_limits<T>::denorm_min();
+    for (const auto& t : tables<T>()) {
+        auto run = [](void (*k)(const T*, T*, size_t), std::vector<T> x) {
+            k(x.data(), x.data(), x.size());
+            return x;
+        };
+        auto e = run(t.exp, { inf, -inf, T(0), T(1000), T(-1000), nan });
+        CHECK(e[0] == inf && e[1] == 0 && e[2] == 1 && e[3] == inf && e[4] == 0 && std::isnan(e[5]));
+        auto l = run(t.log, { T(0), T(-1), inf, T(1), nan, tiny });
+        CHECK(l[0] == -inf && std::isnan(l[1]) && l[2] == inf && l[3] == 0 && std::isnan(l[4]));
+        CHECK(ulp_error(l[5], std::log((long double)tiny)) <= 1);
+        auto s = run(t.sin, { inf, nan, T(0), T(-0.0), T(1e30) });
+        CHECK(std::isnan(s[0]) && std::isnan(s[1]) && s[2] == 0 && std::signbit(s[3]));
+        CHECK(s[4] == std::sin(T(1e30)));
+        auto c = run(t.cos, { inf, T(0), T(1e30) });
+        CHECK(std::isnan(c[0]) && c[1] == 1 && c[2] == std::cos(T(1e30)));
+        auto th = run(t.tanh, { inf, -inf, T(0), nan, T(50) });
+        CHECK(th[0] == 1 && th[1] == -1 && th[2] == 0 && std::isnan(th[3]) && th[4] == 1);
+        auto sg = run(t.sigmoid, { inf, -inf, T(0), nan });
+        CHECK(sg[0] == 1 && sg[1] == 0 && sg[2] == T(0.5) && std::isnan(sg[3]));
+        auto ge = run(t.gelu, { inf, T(0), nan, T(-1e30), T(1e30) });
+        CHECK(ge[0] == inf && ge[1] == 0 && std::isnan(ge[2]) && ge[3] == 0 && ge[4] == T(1e30));
+
+        auto pw = [&](std::vector<T> x, T p) {
+            t.pow(x.data(), p, x.data(), x.size());
+            return x;
+        };
+        auto p3 = pw({ T(0), T(-0.0), inf, nan, T(1), T(-2), -inf }, T(3));
+        CHECK(p3[0] == 0 && std::signbit(p3[1]) && p3[2] == inf && std::isnan(p3[3]) && p3[4] == 1 &&
+              p3[5] == -8 && p3[6] == -inf);
+        auto ph = pw({ T(-1), T(4), T(0), tiny }, T(0.5));
+        CHECK(std::isnan(ph[0]) && ph[1] == 2 && ph[2] == 0 && ph[3] == std::pow(tiny, T(0.5)));
+        auto p0 = pw({ nan, T(0), inf }, T(0));
+        CHECK(p0[0] == 1 && p0[1] == 1 && p0[2] == 1);
+        auto pn = pw({ T(0), T(-0.0), T(2) }, T(-1));
+        CHECK(pn[0] == inf && pn[1] == -inf && pn[2] == T(0.5));
+        auto pb = pw({ T(2), T(0.5) }, inf);
+        CHECK(pb[0] == inf && pb[1] == 0);
+        auto po = pw({ T(10), T(0.1) }, T(sizeof(T) == 4 ? 100 : 400));
+        CHECK(po[0] == inf && po[1] == 0);
+    }
+}
+
+FT_TEST(math, special_values) {
+    special_values<float>();
+    special_values<double>();
+}
+
+// min/max give the second operand for NaN, in vector lanes and in the tail
+template <typename T>
+static void min_max_nan() {
+    const size_t n = 37;
+    std::vector<T> a(n, std::numeric_limits<T>::quiet_NaN()), b(n, T(1)), lo(n), hi(n);
+    auto one = [](T v) { return v == T(1); };
+    for (const auto& t : tables<T>()) {
+        t.binary[size_t(OpKind::Min)](a.data(), b.data(), lo.data(), n);
+        t.binary[size_t(OpKind::Max)](a.data(), b.data(), hi.data(), n);
+        CHECK(std::all_of(lo.begin(), lo.end(), one) && std::all_of(hi.begin(), hi.end(), one));
+    }
+}
+
+FT_TEST(math, min_max_nan) {
+    min_max_nan<float>();
+    min_max_nan<double>();
+}
+
+FT_TEST(math, lazy_unary_ops) {
+    auto a = Tensor<float>::random(-3, 3, { 7, 131 });
+    std::vector<float> v = a.to_vector(), want(v.size());
+
+    Tensor<float> b = a;
+    b.exp().log().evaluate();
+    CHECK_CLOSE(b.to_vector(), v, 1e-6);
+
+    for (size_t i = 0; i < v.size(); ++i) want[i] = std::tanh(v[i]) * 2 + 1 / (1 + std::exp(-v[i]));
+    Tensor<float> c = a, d = a;
+    c.tanh();
+    d.sigmoid();
+    CHECK_CLOSE((c * 2.f + d).evaluate().to_vector(), want, 1e-6);
+
+    for (size_t i = 0; i < v.size(); ++i) want[i] = float(0.5 * v[i] * std::erfc(-v[i] * 0.70710678118654752));
+    Tensor<float> e = a;
+    CHECK_CLOSE(e.gelu().evaluate().to_vector(), want, 1e-6);
+
+    for (size_t i = 0; i < v.size(); ++i) want[i] = std::pow(std::abs(v[i]), 1.5f) + std::sin(v[i]) * std::cos(v[i]);
+    Tensor<float> f = a, s = a, co = a;
+    f.assign(0.f);
+    f = (f + a * a).evaluate();
+    f.sqrt().pow(1.5f);
+    s.sin();
+    co.cos();
+    CHECK_CLOSE((f + s * co).evaluate().to_vector(), want, 1e-5);
+
+    Tensor<int> n({ 4 }, 3);
+    CHECK(n.pow(2).evaluate().to_vector() == (std::vector<int>{ 9, 9, 9, 9 }));
+}
+
+// ------------------------------
+// Fused normalization, against plain double loops
+// ------------------------------
+enum class Ref { Softmax, LogSoftmax, LayerNorm, RmsNorm };
+
+template <typename T>
+static std::vector<T> reference(const Tensor<T>& a, size_t axis, Ref kind, double eps,
+                                const std::vector<T>& gamma, const std::vector<T>& beta) {
+    auto shp = a.shape();
+    size_t outer = 1, n = shp[axis], inner = 1;
+    for (size_t d = 0; d < axis; ++d) outer *= shp[d];
+    for (size_t d = axis + 1; d < shp.size(); ++d) inner *= shp[d];
+    std::vector<T> x = a.contiguous().to_vector(), y(x.size());
+    for (size_t o = 0; o < outer; ++o)
+        for (size_t c = 0; c < inner; ++c) {
+            auto at = [&](size_t i) { return o * n * inner + i * inner + c; };
+            double mx = -INFINITY, s = 0, m = 0, q = 0;
+            for (size_t i = 0; i < n; ++i) mx = std::max(mx, double(x[at(i)]));
+            for (size_t i = 0; i < n; ++i) s += std::exp(double(x[at(i)]) - mx);
+            if (kind == Ref::LayerNorm)
+                for (size_t i = 0; i < n; ++i) m += double(x[at(i)]) / n;
+            for (size_t i = 0; i < n; ++i) q += (x[at(i)] - m) * (x[at(i)] - m) / n;
+            for (size_t i = 0; i < n; ++i) {
+                double v = x[at(i)], r;
+                if (kind == Ref::Softmax) r = std::exp(v - mx) / s;
+                else if (kind == Ref::LogSoftmax) r = v - mx - std::log(s);
+                else r = (v - m) / std::sqrt(q + eps) * (gamma.empty() ? 1.0 : double(gamma[i])) +
+                         (beta.empty() ? 0.0 : double(beta[i]));
+                y[at(i)] = T(r);
+            }
+        }
+    return y;
+}
+
+// Fixed inputs: a row of near-equal values is ill-conditioned for the norms
+template <typename T>
+static Tensor<T> sample(const std::vector<size_t>& shp, T lo, T hi, unsigned seed) {
+    size_t n = 1;
+    for (auto d : shp) n *= d;
+    std::mt19937 g(seed);
+    std::uniform_real_distribution<double> d(lo, hi);
+    std::vector<T> v(n);
+    for (auto& x : v) x = T(d(g));
+    return Tensor<T>(v).reshaped(shp);
+}
+
+template <typename T>
+static void normalization(double tol) {
+    const std::vector<std::vector<size_t>> shapes = { { 1 }, { 9 }, { 3, 1000 }, { 2, 37, 5 }, { 4, 300, 3 },
+                                                      { 65, 17 }, { 2, 3, 513 }, { 9000 } };
+    for (const auto& shp : shapes)
+        for (size_t axis = 0; axis < shp.size(); ++axis) {
+            auto a = sample<T>(shp, T(-8), T(8), unsigned(axis));
+            size_t n = shp[axis];
+            auto g = sample<T>({ n }, T(0.5), T(2), 1), b = sample<T>({ n }, T(-1), T(1), 2);
+            CHECK_CLOSE(a.softmax(axis).to_vector(), reference(a, axis, Ref::Softmax, 0, {}, {}), tol);
+            CHECK_CLOSE(a.log_softmax(axis).to_vector(), reference(a, axis, Ref::LogSoftmax, 0, {}, {}), tol);
+            CHECK_CLOSE(a.layernorm(axis, T(1e-5)).to_vector(), reference(a, axis, Ref::LayerNorm, 1e-5, {}, {}), tol);
+            CHECK_CLOSE(a.layernorm(axis, T(1e-5), g, b).to_vector(),
+                        reference(a, axis, Ref::LayerNorm, 1e-5, g.to_vector(), b.to_vector()), tol);
+            CHECK_CLOSE(a.rmsnorm(axis, T(1e-6), g).to_vector(),
+                        reference(a, axis, Ref::RmsNorm, 1e-6, g.to_vector(), {}), tol);
+            // Strided input
+            auto at = a.transpose();
+            size_t ax = shp.size() - 1 - axis;
+            CHECK_CLOSE(at.softmax(ax).to_vector(), reference(at, ax, Ref::Softmax, 0, {}, {}), tol);
+        }
+}
+
+FT_TEST(math, normalization_float) { normalization<float>(1e-4); }
+FT_TEST(math, normalization_double) { normalization<double>(1e-12); }
+
+FT_TEST(math, normalization_edges) {
+    // Large logits stay finite, rows sum to 1
+    Tensor<float> big(std::vector<float>{ 1000.f, 1000.f, -1000.f, 999.f });
+    auto p = big.softmax(0).to_vector();
+    CHECK(std::abs(p[0] + p[1] + p[2] + p[3] - 1) < 1e-6f && p[2] == 0);
+    CHECK_NEAR(big.log_softmax(0).to_vector()[3], std::log(p[3]), 1e-5);
+    auto r = Tensor<float>::random(-1, 1, { 5, 64, 7 }).softmax(1).sum({ 1 }).to_vector();
+    CHECK_CLOSE(r, std::vector<float>(35, 1.f), 1e-5);
+    // A constant row has zero variance and normalizes to beta
+    Tensor<double> c({ 2, 6 }, 3.0);
+    CHECK_CLOSE(c.layernorm(1, 1e-5, Tensor<double>(), Tensor<double>({ 6 }, 0.25)).to_vector(),
+                std::vector<double>(12, 0.25), 1e-12);
+    CHECK(Tensor<float>({ 0, 5 }).softmax(1).shape() == (std::vector<size_t>{ 0, 5 }));
+    CHECK_THROWS(big.softmax(1));
+    CHECK_THROWS(big.layernorm(0, 1e-5f, Tensor<float>({ 3 }, 1.f)));
+    CHECK_THROWS(Tensor<float>({ 2, 4 }).rmsnorm(1, 1e-6f, Tensor<float>({ 2, 4 }, 1.f)));
+}
+
+FT_TEST(math, linear_activations) {
+    for (Activation act : { Activation::Sigmoid, Activation::Tanh, Activation::Gelu }) {
+        auto x = Tensor<double>::random(-2, 2, { 33, 19 });
+        auto W = Tensor<double>::random(-1, 1, { 45, 19 });
+        auto bias = Tensor<double>::random(-1, 1, { 45 });
+        auto ref = x.matmul(W.transpose()).to_vector();
+        auto bv = bias.to_vector();
+        for (size_t i = 0; i < ref.size(); ++i) ref[i] = Gemm<double>::activate(ref[i] + bv[i % 45], act);
+        CHECK_CLOSE(x.linear(W, bias, act).to_vector(), ref, 1e-13);
+    }
+}
@@ -0,0 +1,56 @@
+#include "testing.hpp"
+
+// Enables the profiler for one scope, restores the previous state
+struct Profiling {
+    bool was = Profiler::global().enabled();
+    Profiling() { Profiler::global().clear(); Profiler::global().enable(); }
+    ~Profiling() { Profiler::global().enable(was); Profiler::global().clear(); }
+};
+
+FT_TEST(profiler, off_records_nothing) {
+    bool was = Profiler::global().enabled();
+    Profiler::global().disable();
+    Profiler::global().clear();
+    auto a = Tensor<float>::ones({ 1000 });
+    (a + a).evaluate().sum();
+    CHECK(Profiler::global().events().empty());
+    Profiler::global().enable(was);
+}
+
+FT_TEST(profiler, records_lazy_ops) {
+    Profiling on;
+    size_t n = 1 << 20;
+    auto a = Tensor<float>::ones({ n }), b = Tensor<float>::ones({ n });
+    auto r = (a + b * 2.f).evaluate();
+    r.sum();
+    r.reshaped({ 1024, 1024 }).sum({ 1 });
+    auto ev = Tensor<float>::profiler().events();
+    CHECK(ev.size() == 3);
+    CHECK(ev[0].name == "lazy.execute" && ev[1].name == "stat.summarize" && ev[2].name == "stat.reduce_axes");
+    // a and b read, r written; two element ops
+    CHECK(ev[0].bytes == 3 * n * sizeof(float) && ev[0].flops == 2 * n);
+    for (auto& e : ev) {
+        CHECK(e.chunks >= 1 && e.threads >= 1 && e.threads <= Executor::global().num_threads());
+        CHECK(e.threads <= e.chunks);
+    }
+    CHECK(ev[1].bytes == n * sizeof(float));
+    auto t = Profiler::global().totals();
+    CHECK(t["lazy.execute"].count == 1 && t["lazy.execute"].gbps() > 0);
+}
+
+FT_TEST(profiler, nested_events_and_trace) {
+    Profiling on;
+    auto x = Tensor<float>::ones({ 4, 8 }), row = Tensor<float>::ones({ 8 });
+    // broadcast sub-chain: evaluated once, nested inside the outer execute
+    auto y = (x + (row + row)).evaluate();
+    auto ev = Profiler::global().events();
+    CHECK(y.to_vector() == std::vector<float>(32, 3.f));
+    CHECK(ev.size() == 2 && ev[0].depth == 1 && ev[1].depth == 0);
+    CHECK(ev[0].start_ns >= ev[1].start_ns && ev[0].dur_ns <= ev[1].dur_ns);
+    std::string json = Profiler::global().chrome_trace();
+    CHECK(json.find("\"traceEvents\":[{") != std::string::npos);
+    CHECK(json.find("\"name\":\"lazy.execute\"") != std::string::npos && json.find("\"ph\":\"X\"") != std::string::npos);
+    std::ostringstream os;
+    Profiler::global().report(os);
+    CHECK(os.str().find("lazy.execute") != std::string::npos);
+}
@@ -0,0 +1,131 @@
+#include "testing.hpp"
+
+FT_TEST(quant, half_round_trip) {
+    for (uint32_t h = 0; h < 65536; ++h) {
+        float f = simd::half_to_float(uint16_t(h));
+        uint16_t back = simd::half_from_float(f);
+        if (std::isnan(f)) CHECK((back & 0x7c00) == 0x7c00 && (back & 0x3ff));
+        else CHECK(back == h);
+    }
+    std::mt19937 g(1);
+    std::uniform_real_distribution<float> d(-70000.f, 70000.f);
+    std::vector<float> xs(100000);
+    for (auto& x : xs) x = g() % 3 ? d(g) : d(g) * 1e-8f;
+    std::vector<uint16_t> a(xs.size()), b(xs.size());
+    simd::quant_kernels().to_half(xs.data(), a.data(), xs.size());
+    simd::ScalarQ::to_half(xs.data(), b.data(), xs.size());
+    CHECK(a == b);
+}
+
+FT_TEST(quant, kernels_match_scalar) {
+    std::mt19937 g(2);
+    std::uniform_real_distribution<float> d(-300, 300);
+    std::vector<float> xs(1000);
+    for (auto& x : xs) x = d(g);
+    xs[7] = NAN; xs[8] = 0.5f; xs[9] = 1.5f; xs[10] = -2.5f;
+    std::vector<int8_t> a(1000), b(1000);
+    std::vector<uint8_t> c(1000), e(1000);
+    simd::quant_kernels().quantize(xs.data(), xs.size(), 1.f, 3, a.data());
+    simd::ScalarQ::quantize(xs.data(), xs.size(), 1.f, 3, b.data());
+    simd::quant_kernels().quantize(xs.data(), xs.size(), 0.7f, 100, c.data());
+    simd::ScalarQ::quantize(xs.data(), xs.size(), 0.7f, 100, e.data());
+    CHECK(a == b && c == e);
+
+    const auto& kt = simd::quant_kernels();
+    for (size_t n : { 1, 15, 16, 31, 32, 33, 100, 1000, 4099 }) {
+        size_t R = kt.tile_rows;
+        std::vector<int8_t> p(R * (n + 3)), q(4 * (n + 5));
+        for (auto& x : p) x = int8_t(g());
+        for (auto& x : q) x = int8_t(g());
+        p[0] = -128; q[0] = -128;
+        CHECK(kt.dot(p.data(), q.data(), n) == simd::ScalarQ::dot(p.data(), q.data(), n));
+        int32_t r4[4], ref4[4];
+        kt.dot4(p.data(), q.data(), n + 5, n, r4);
+        simd::ScalarQ::dot4(p.data(), q.data(), n + 5, n, ref4);
+        CHECK(std::equal(r4, r4 + 4, ref4));
+        std::vector<int32_t> r(R * 7);
+        kt.tile(p.data(), n + 3, q.data(), n + 5, n, r.data(), 7);
+        for (size_t i = 0; i < R; ++i)
+            for (size_t j = 0; j < 4; ++j)
+                CHECK(r[i * 7 + j] == simd::ScalarQ::dot(p.data() + i * (n + 3), q.data() + j * (n + 5), n));
+    }
+}
+
+FT_TEST(quant, nan_saturates_high) {
+    std::vector<float> xs(37, NAN);
+    for (auto isa : { simd::Isa::Scalar, simd::Isa::Neon, simd::Isa::Sse42, simd::Isa::Avx2, simd::Isa::Avx512 }) {
+        if (isa > simd::active_isa()) break;
+        auto kt = simd::select_quant_table(isa);
+        std::vector<int8_t> a(xs.size());
+        std::vector<uint8_t> b(xs.size());
+        kt.quantize(xs.data(), xs.size(), 0.5f, -3, a.data());
+        kt.quantize(xs.data(), xs.size(), 0.5f, 100, b.data());
+        CHECK(std::all_of(a.begin(), a.end(), [](int8_t q) { return q == 127; }));
+        CHECK(std::all_of(b.begin(), b.end(), [](uint8_t q) { return q == 255; }));
+    }
+}
+
+FT_TEST(quant, quantize_dequantize) {
+    auto x = Tensor<float>::random(-2.f, 3.f, { 37, 65 });
+    for (bool sym : { true, false })
+        for (long axis : { -1L, 0L, 1L }) {
+            auto q8 = QTensor<int8_t>::quantize(x, sym, axis);
+            auto qu = QTensor<uint8_t>::quantize(x, sym, axis);
+            auto& s8 = q8.qparams().scale;
+            auto& su = qu.qparams().scale;
+            CHECK_CLOSE(q8.dequantize().to_vector(), x.to_vector(), *std::max_element(s8.begin(), s8.end()));
+            CHECK_CLOSE(qu.dequantize().to_vector(), x.to_vector(), *std::max_element(su.begin(), su.end()));
+        }
+}
+
+FT_TEST(quant, elementwise) {
+    auto a = Tensor<float>::random(-1, 1, { 1000 }), b = Tensor<float>::random(-1, 1, { 1000 });
+    auto qa = QTensor<int8_t>::quantize(a), qb = QTensor<int8_t>::quantize(b);
+    QParams po;
+    po.scale = { 2.f / 127 };
+    po.zero_point = { 0 };
+    auto qs = qa.add(qb, po).dequantize().to_vector(), qm = qa.mul(qb, po).dequantize().to_vector();
+    auto fa = qa.dequantize().to_vector(), fb = qb.dequantize().to_vector();
+    for (size_t i = 0; i < 1000; ++i) {
+        CHECK(std::abs(qs[i] - (fa[i] + fb[i])) <= po.scale[0] * 0.5f + 1e-6f);
+        CHECK(std::abs(qm[i] - (fa[i] * fb[i])) <= po.scale[0] * 0.5f + 1e-6f);
+    }
+    auto pc = QTensor<uint8_t>::quantize(a.reshaped({ 10, 100 }), false, 0);
+    QParams p2 = pc.qparams();
+    for (auto& sc : p2.scale) sc *= 2;
+    CHECK(pc.add(pc, p2).to_vector() == pc.to_vector());
+}
+
+FT_TEST(quant, products) {
+    for (size_t M : { 1, 3, 17 })
+        for (bool sym : { true, false }) {
+            auto A = Tensor<float>::random(-1, 1, { M, 70 });
+            auto W = Tensor<float>::random(-1, 1, { 33, 70 });
+            auto bias = Tensor<float>::random(-1, 1, { 33 });
+            auto qa = QTensor<int8_t>::quantize(A, sym);
+            auto qau = QTensor<uint8_t>::quantize(A, sym);
+            auto Bt = QTensor<int8_t>::quantize(W.transpose().contiguous(), sym, 1);
+            auto Btu = QTensor<uint8_t>::quantize(W.transpose().contiguous(), sym, 1);
+            CHECK_CLOSE(qa.matmul(Bt).to_vector(), qa.dequantize().matmul(Bt.dequantize()).to_vector(), 1e-4);
+            CHECK_CLOSE(qa.matmul(Btu).to_vector(), qa.dequantize().matmul(Btu.dequantize()).to_vector(), 1e-4);
+            CHECK_CLOSE(qau.matmul(Bt).to_vector(), qau.dequantize().matmul(Bt.dequantize()).to_vector(), 1e-4);
+            // dynamic input quantization: float result within quantization error
+            auto qw = QTensor<int8_t>::quantize(W, sym, 0);
+            CHECK_CLOSE(A.linear(qw, bias, Activation::Relu).to_vector(),
+                        A.linear(W, bias, Activation::Relu).to_vector(), 0.08);
+            auto v = QTensor<int8_t>::quantize(Tensor<float>::random(-1, 1, { 500 }), sym);
+            auto vu = QTensor<uint8_t>::quantize(Tensor<float>::random(-1, 1, { 500 }), sym);
+            CHECK_NEAR(v.dot(vu), v.dequantize().dot(vu.dequantize()), 1e-3);
+        }
+}
+
+FT_TEST(quant, half_linear) {
+    for (size_t M : { 1, 3, 40 }) {
+        auto A = Tensor<float>::random(-1, 1, { M, 300 });
+        auto W = Tensor<float>::random(-1, 1, { 600, 300 });
+        auto bias = Tensor<float>::random(-1, 1, { 600 });
+        HalfTensor hw(W);
+        CHECK_CLOSE(A.linear(hw, bias, Activation::Tanh).to_vector(),
+                    A.linear(hw.to_float(), bias, Activation::Tanh).to_vector(), 1e-4);
+    }
+}
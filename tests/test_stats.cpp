@@ -0,0 +1,54 @@
+#include "testing.hpp"
+
+FT_TEST(stats, fused_full_reductions) {
+    for (size_t n : { 1, 5, 300, 100000, 1000003 }) {
+        auto r = Tensor<float>::random(-1.f, 1.f, { n });
+        auto v = r.stats({ StatKind::Sum, StatKind::Min, StatKind::Max, StatKind::ArgMin, StatKind::ArgMax, StatKind::Mean });
+        CHECK(v[1] == r.min() && v[2] == r.max());
+        CHECK(r.argmax() == size_t(v[4]) && r.argmin() == size_t(v[3]));
+        CHECK_NEAR(v[5], v[0] / float(n), 1e-3);
+    }
+}
+
+FT_TEST(stats, precision) {
+    Tensor<double> d = Tensor<double>::fill({ 1000000 }, 1.0);
+    d.add(Tensor<double>::fill({ 1 }, 1e8)).evaluate();
+    CHECK(d.sum() == 1e6 * (1e8 + 1));
+    CHECK_NEAR(d.var(), 0.0, 1e-12);
+    CHECK_NEAR(Tensor<float>::fill({ 10000000 }, 0.1f).sum(), 1e6, 1e-5);
+    Tensor<int> iv({ 4 });
+    iv.add(Tensor<int>::fill({ 1 }, 3)).evaluate();
+    CHECK(iv.sum() == 12 && iv.mean() == 3 && iv.var() == 0);
+    CHECK_THROWS(Tensor<float>().max());
+}
+
+FT_TEST(stats, axis_reductions) {
+    Tensor<float> m({ 3, 4, 5 }, 1.f);
+    auto r = Tensor<float>::random(0.f, 1.f, { 3, 4, 5 });
+    for (auto axes : std::vector<std::vector<size_t>>{ { 0 }, { 1 }, { 2 }, { 0, 1 }, { 1, 2 }, { 0, 2 }, { 0, 1, 2 } }) {
+        CHECK_NEAR(r.sum(axes).sum(), r.sum(), 1e-4);
+        CHECK(r.max(axes).max() == r.max());
+        CHECK(r.min(axes).min() == r.min());
+        auto c = m.sum(axes);
+        float L = 60.f / float(c.len());
+        CHECK(c.min() == L && c.max() == L);
+        CHECK(m.var(axes).max() == 0.f);
+    }
+    CHECK(m.sum({ 1 }, true).shape() == (std::vector<size_t>{ 3, 1, 5 }));
+    CHECK_THROWS(m.sum({ 3 }));
+}
+
+FT_TEST(stats, arg_and_var_along_axis) {
+    Tensor<float> g({ 2, 3 }, 0.f);
+    g.assign({ 0, 2 }, { 1, 3 }, 5.f);
+    g.assign({ 1, 0 }, { 2, 1 }, 7.f);
+    auto a1 = g.argmax(1);
+    CHECK(a1.at({ 0 }) == 2 && a1.at({ 1 }) == 0);
+    CHECK(g.argmax(0).sum() == 1);
+    Tensor<double> h({ 2, 4 });
+    h.assign({ 0, 0 }, { 1, 2 }, 2.0);
+    auto hv = h.var({ 1 });
+    CHECK_NEAR(hv.max(), 1.0, 1e-12);
+    CHECK(hv.min() == 0.0);
+    CHECK_NEAR(h.stddev({ 1 }, 1).max(), std::sqrt(4.0 / 3), 1e-12);
+}
@@ -0,0 +1,77 @@
+#include "testing.hpp"
+
+FT_TEST(views, copy_on_write) {
+    auto a = Tensor<float>::random(-1.f, 1.f, { 4, 6 });
+    std::vector<float> av = a.to_vector();
+    Tensor<float> b = a;
+    b.assign({ 0, 0 }, { 2, 3 }, 9.f);
+    CHECK(a.to_vector() == av && b.at({ 1, 2 }) == 9.f && b.at({ 2, 2 }) == av[14]);
+    auto c = (a + a).evaluate();
+    CHECK(a.to_vector() == av && c.at({ 3, 5 }) == 2 * av[23]);
+    CHECK_THROWS(Tensor<float>().assign({}, {}, 1.f));
+    CHECK_THROWS(Tensor<float>().assign(1.f));
+    Tensor<float> d = a;
+    d.assign(4.f);
+    CHECK(a.to_vector() == av && d.min() == 4.f && d.max() == 4.f);
+    d.assign(5.f);
+    CHECK(d.min() == 5.f && d.max() == 5.f);
+}
+
+FT_TEST(views, transpose_and_contiguous) {
+    auto a = Tensor<float>::random(-1.f, 1.f, { 4, 6 });
+    std::vector<float> av = a.to_vector();
+    auto t = a.transpose();
+    CHECK(t.shape() == (std::vector<size_t>{ 6, 4 }) && !t.is_contiguous());
+    for (size_t i = 0; i < 6; ++i)
+        for (size_t j = 0; j < 4; ++j) CHECK(t.at({ i, j }) == av[j * 6 + i]);
+    CHECK(t.contiguous().to_vector()[1] == av[6]);
+    CHECK(a.reshaped({ 24 }).to_vector() == av);
+}
+
+FT_TEST(views, strided_and_broadcast_operands) {
+    auto a = Tensor<float>::random(-1.f, 1.f, { 4, 6 });
+    std::vector<float> av = a.to_vector();
+    auto t = a.transpose();
+    auto ones = Tensor<float>::ones({ 6, 4 });
+    auto s = (ones + t).evaluate(), s2 = (t + ones).evaluate();
+    for (size_t i = 0; i < 6; ++i)
+        for (size_t j = 0; j < 4; ++j) CHECK(s.at({ i, j }) == 1.f + av[j * 6 + i] && s2.at({ i, j }) == s.at({ i, j }));
+    auto row = a.slice(0, 1, 2);
+    auto bc = (a - row).evaluate();
+    for (size_t i = 0; i < 4; ++i)
+        for (size_t j = 0; j < 6; ++j) CHECK(bc.at({ i, j }) == av[i * 6 + j] - av[6 + j]);
+    auto col = a.slice(1, 2, 3);
+    auto bc2 = (col * ones.transpose()).evaluate();
+    for (size_t i = 0; i < 4; ++i)
+        for (size_t j = 0; j < 6; ++j) CHECK(bc2.at({ i, j }) == av[i * 6 + 2]);
+    auto z = (a + (t.transpose() * 2.f)).evaluate();
+    CHECK_NEAR(z.at({ 3, 4 }), 3 * av[22], 1e-6);
+}
+
+FT_TEST(views, step_slice_and_expand) {
+    auto a = Tensor<float>::random(-1.f, 1.f, { 4, 6 });
+    std::vector<float> av = a.to_vector();
+    auto ev = a.slice(1, 0, 6, 2);
+    CHECK(ev.shape()[1] == 3 && ev.at({ 2, 1 }) == av[2 * 6 + 2]);
+    CHECK((ev * 2.f).evaluate().at({ 3, 2 }) == 2 * av[3 * 6 + 4]);
+    auto row = a.slice(0, 1, 2);
+    CHECK_NEAR(row.expand({ 5, 6 }).sum(), 5 * row.sum(), 1e-4);
+    CHECK_THROWS(a.slice(2, 0, 1));
+    CHECK_THROWS(a.expand({ 3, 6 }));
+}
+
+FT_TEST(views, reductions_and_assign_on_views) {
+    auto a = Tensor<float>::random(-1.f, 1.f, { 4, 6 });
+    std::vector<float> av = a.to_vector();
+    auto t = a.transpose();
+    auto ts = t.sum({ 1 });
+    for (size_t i = 0; i < 6; ++i) {
+        float x = 0;
+        for (size_t j = 0; j < 4; ++j) x += av[j * 6 + i];
+        CHECK_NEAR(ts.at({ i }), x, 1e-5);
+    }
+    CHECK_NEAR(t.sum(), a.sum(), 1e-4);
+    auto tv = t;
+    tv.assign({ 1, 1 }, { 3, 2 }, 5.f);
+    CHECK(tv.at({ 2, 1 }) == 5.f && tv.at({ 0, 0 }) == av[0] && a.to_vector() == av);
+}
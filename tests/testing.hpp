@@ -0,0 +1,81 @@
+#pragma once
+
+#include "FTensor.tpp"
+#include <cstring>
+#include <sstream>
+#include <string>
+
+/* Minimal test harness: FT_TEST(suite, name) registers a case, the runner
+   (main.cpp) takes suite names as filters. CHECK failures throw, so one
+   failing case does not stop the rest. */
+
+namespace ft_test {
+
+struct Case {
+    const char* suite;
+    const char* name;
+    void (*fn)();
+};
+
+inline std::vector<Case>& registry() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+struct Register {
+    Register(const char* suite, const char* name, void (*fn)()) { registry().push_back({ suite, name, fn }); }
+};
+
+struct Failure : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+[[noreturn]] inline void fail(const char* file, int line, const std::string& what) {
+    std::ostringstream os;
+    os << file << ":" << line << ": " << what;
+    throw Failure(os.str());
+}
+
+// |a - b| <= tol * max(1, |b|)
+inline bool near(double a, double b, double tol) {
+    return std::abs(a - b) <= tol * std::max(1.0, std::abs(b));
+}
+
+template <typename T>
+void check_close(const std::vector<T>& got, const std::vector<T>& want, double tol, const char* file, int line) {
+    if (got.size() != want.size())
+        fail(file, line, "size " + std::to_string(got.size()) + " != " + std::to_string(want.size()));
+    for (size_t i = 0; i < got.size(); ++i)
+        if (!near(double(got[i]), double(want[i]), tol)) {
+            std::ostringstream os;
+            os << "element " << i << ": " << double(got[i]) << " != " << double(want[i]);
+            fail(file, line, os.str());
+        }
+}
+
+} // namespace ft_test
+
+#define FT_TEST(suite, name)                                                    \
+    static void suite##_##name();                                               \
+    static ft_test::Register suite##_##name##_reg(#suite, #name, suite##_##name); \
+    static void suite##_##name()
+
+#define CHECK(cond)                                                             \
+    do { if (!(cond)) ft_test::fail(__FILE__, __LINE__, "CHECK(" #cond ")"); } while (0)
+
+#define CHECK_NEAR(a, b, tol)                                                   \
+    do {                                                                        \
+        double a_ = double(a), b_ = double(b);                                  \
+        if (!ft_test::near(a_, b_, tol))                                        \
+            ft_test::fail(__FILE__, __LINE__, #a " = " + std::to_string(a_) +   \
+                          ", expected " + std::to_string(b_));                  \
+    } while (0)
+
+#define CHECK_CLOSE(got, want, tol) ft_test::check_close(got, want, tol, __FILE__, __LINE__)
+
+#define CHECK_THROWS(expr)                                                      \
+    do {                                                                        \
+        bool thrown_ = false;                                                   \
+        try { (void)(expr); } catch (const std::exception&) { thrown_ = true; } \
+        if (!thrown_) ft_test::fail(__FILE__, __LINE__, "no exception from " #expr); \
+    } while (0)
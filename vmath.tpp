@@ -0,0 +1,583 @@
+#pragma once
+
+#include "pch.tpp"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+/* Vector math.
+   exp, log, sin/cos, tanh, sigmoid, gelu and pow by range reduction and
+   polynomials, written once against the primitive set of a floating-point
+   SIMD traits struct and expanded per ISA by FT_SIMD_MATH, plus the row
+   kernels of the fused softmax / log-softmax / layer norm / RMS norm.
+
+   Polynomials are Chebyshev fits of the reduced functions, computed in
+   quad precision. Worst error measured against a quad-precision reference
+   on every x86 ISA, float / double (tests/test_math.cpp holds the bounds):
+     exp      1 / 1 ulp           all finite x
+     log      1 / 1 ulp           all positive x
+     sin, cos 4 / 3 ulp           |x| <= 8192 / 1e6, wider |x| use libm;
+                                  2 ulp with FMA, 1.5 ulp for |x| <= 10
+     tanh     2 / 2 ulp
+     sigmoid  3 / 3 ulp
+     gelu     2 / 2 ulp           x >= 0, x * Phi(x) in the exact erf form
+              16 / 10 ulp         x < 0, where 1 - erf(-x / sqrt 2)
+                                  cancels around x = -1.4; 7 / 6 ulp in
+                                  the erfc tail
+     pow      3 / 3 ulp           |p log x| <= 64; the error grows with
+                                  |p log x| up to 8 ulp at the overflow edge
+   The scalar table (FT_SIMD=scalar, integer types) calls libm instead.
+   Special values follow libm: NaN in, NaN out; log(0) = -inf, log(x < 0)
+   = NaN; exp and pow overflow to inf and underflow through subnormals. */
+
+namespace simd {
+
+template <typename T> struct MathConst;
+
+template <>
+struct MathConst<float> {
+    using Bits = uint32_t;
+    static constexpr Bits kMantMask = 0x007fffffu, kOne = 0x3f800000u;
+    static constexpr float kBias = 127.0f, kMinNormal = 1.17549435e-38f;
+    static constexpr float kSubnormalScale = 33554432.0f, kSubnormalExp = 25.0f;   // 2^25
+    static constexpr float kSplit = 4097.0f;   // 2^12 + 1, Dekker product without FMA
+    static constexpr float kSqrt2 = 1.41421356f, kSqrtHalf = 0.707106781f;
+
+    // exp: x = n ln2 + r, |r| <= ln2 / 2, e^r = 1 + r + r^2 P(r)
+    static constexpr float kLog2e = 1.44269504f;
+    static constexpr float kLn2Hi = 0.693359375f, kLn2Lo = -2.12194440e-4f;   // n * kLn2Hi exact
+    static constexpr float kExpMin = -104.0f, kExpMax = 89.0f;                // 0 and inf beyond
+    static constexpr float kExp[] = { 5.000000013e-1f, 1.666666668e-1f, 4.166646501e-2f,
+                                      8.333310934e-3f, 1.393364103e-3f, 1.989098087e-4f };
+    // log(1 + f) = 2s + s R, s = f / (2 + f), R = 2 z P(z), z = s^2
+    static constexpr float kLog[] = { 3.333333328e-1f, 2.000006092e-1f, 1.427541041e-1f, 1.166523361e-1f };
+
+    // sin/cos: x = k pi/2 + r, pi/2 split so k * kPio2[0..1] is exact for k < 2^13
+    static constexpr float kTwoOverPi = 0.636619772f, kTrigMax = 8192.0f;
+    static constexpr float kPio2[] = { 1.5703125f, 4.837512969970703125e-4f, 7.54978995489188216e-8f, 0.0f };
+    static constexpr float kSin[] = { -1.666666466e-1f, 8.332748271e-3f, -1.958789088e-4f };   // r + r z P(z)
+    static constexpr float kCos[] = { 4.166666466e-2f, -1.388830304e-3f, 2.454794209e-5f };    // 1 - z/2 + z^2 P(z)
+
+    // tanh: x + x z P(z) below kTanhSmall, 1 - 2 / (e^2x + 1) above
+    static constexpr float kTanhSmall = 0.625f;
+    static constexpr float kTanh[] = { -3.333332894e-1f, 1.333276974e-1f, -5.385090958e-2f,
+                                       2.099717900e-2f, -6.096714166e-3f };
+
+    // gelu: x Phi(x), Phi(x) = erfc(-x / sqrt 2) / 2. erf(v) = v P(v^2) for
+    // v < 1; erfc(v) = e^-v^2 P(s) on [1, 2] with s = 2v - 3, and
+    // e^-v^2 P(s) / v above with s mapped from w = 1 / v^2
+    static constexpr float kGeluMax = 13.4f;   // gelu(-x) is subnormal past here, flushed to 0
+    static constexpr float kErf[] = { 1.128379166e+0f, -3.761262667e-1f, 1.128359472e-1f, -2.685421201e-2f,
+                                      5.189087423e-3f, -8.016864287e-4f, 7.875875063e-5f };
+    static constexpr float kErfcV[] = { 3.215854165e-1f, -8.181145360e-2f, 1.903775914e-2f, -4.116433268e-3f,
+                                        8.360948062e-4f, -1.605600138e-4f, 2.943144984e-5f, -5.502442403e-6f,
+                                        9.242911338e-7f };
+    static constexpr float kErfcMid[] = { 10.6666667f, -1.66666667f };   // v in [2, 4]
+    static constexpr float kErfcW1[] = { 5.277490693e-1f, -1.839317745e-2f, 1.612291443e-3f, -2.037644049e-4f,
+                                         3.194204202e-5f, -6.292327085e-6f, 1.287619155e-6f };
+    static constexpr float kErfcTail[] = { 38.8956229f, -1.43097643f };  // v in [4, 9.5]
+    static constexpr float kErfcW2[] = { 5.543371665e-1f, -6.546764244e-3f, 2.181631868e-4f, -1.153830646e-5f,
+                                         8.073187614e-7f };
+};
+
+template <>
+struct MathConst<double> {
+    using Bits = uint64_t;
+    static constexpr Bits kMantMask = 0x000fffffffffffffull, kOne = 0x3ff0000000000000ull;
+    static constexpr double kBias = 1023.0, kMinNormal = 2.2250738585072014e-308;
+    static constexpr double kSubnormalScale = 18014398509481984.0, kSubnormalExp = 54.0;   // 2^54
+    static constexpr double kSplit = 134217729.0;   // 2^27 + 1
+    static constexpr double kSqrt2 = 1.4142135623730951, kSqrtHalf = 0.70710678118654752;
+
+    static constexpr double kLog2e = 1.4426950408889634;
+    static constexpr double kLn2Hi = 6.93147180369123816490e-01, kLn2Lo = 1.90821492927058770002e-10;
+    static constexpr double kExpMin = -746.0, kExpMax = 710.0;
+    static constexpr double kExp[] = {
+        5.00000000000000000000e-01, 1.66666666666666709863e-01, 4.16666666666666697515e-02,
+        8.33333333332614088398e-03, 1.38888888888837524166e-03, 1.98412698748004919808e-04,
+        2.48015873255333638190e-05, 2.75572554257464342818e-06, 2.75572736613486362189e-07,
+        2.51052063739570111153e-08, 2.09146793765839350408e-09 };
+    static constexpr double kLog[] = {
+        3.33333333333333333340e-01, 1.99999999999999962504e-01, 1.42857142857176795522e-01,
+        1.11111111099293675705e-01, 9.09090929682838152236e-02, 7.69228756616504865153e-02,
+        6.66781933491991110698e-02, 5.84406182143155525744e-02, 5.94099860148073072603e-02 };
+
+    // k * kPio2[0..2] exact for k < 2^20
+    static constexpr double kTwoOverPi = 6.36619772367581382433e-01, kTrigMax = 1.0e6;
+    static constexpr double kPio2[] = { 1.57079632673412561417e+00, 6.07710050630396597660e-11,
+                                        2.02226624871116645580e-21, 8.47842766036889956997e-32 };
+    static constexpr double kSin[] = {
+        -1.66666666666666646235e-01, 8.33333333333094848555e-03, -1.98412698367585743230e-04,
+        2.75573161025524401188e-06, -2.50511318450036244168e-08, 1.59181292948666086668e-10 };
+    static constexpr double kCos[] = {
+        4.16666666666666653887e-02, -1.38888888888873972367e-03, 2.48015872987656879273e-05,
+        -2.75573172717297928820e-07, 2.08761462684031978934e-09, -1.13826324255217180055e-11 };
+
+    static constexpr double kTanhSmall = 0.625;
+    static constexpr double kTanh[] = {
+        -3.33333333333333329379e-01, 1.33333333333330416022e-01, -5.39682539678969916896e-02,
+        2.18694885190083057558e-02, -8.86323510324087792496e-03, 3.59212175115496226949e-03,
+        -1.45577541204780551035e-03, 5.89660657775704334691e-04, -2.37590649605556195476e-04,
+        9.25711612955676826521e-05, -3.12011014257973999800e-05, 6.48516348279311312786e-06 };
+
+    static constexpr double kGeluMax = 38.0;   // gelu(-x) is subnormal past here, flushed to 0
+    static constexpr double kErf[] = {
+        1.12837916709551256654e+00, -3.76126389031835404385e-01, 1.12837916709450062655e-01,
+        -2.68661706432377703602e-02, 5.22397760711642273211e-03, -8.54832597538969208056e-04,
+        1.20552949048397079165e-04, -1.49247369074196603376e-05, 1.64474247033173624103e-06,
+        -1.62084838018717059023e-07, 1.37200645467776856066e-08, -7.79589882700214224624e-10 };
+    static constexpr double kErfcV[] = {
+        3.21585416454317502354e-01, -8.18114588662800265615e-02, 1.90377599638693496479e-02,
+        -4.11636316244565924058e-03, 8.36083809566712092757e-04, -1.60811173369930715549e-04,
+        2.94708574529999604221e-05, -5.17132867272212045378e-06, 8.72304473829848006573e-07,
+        -1.41911861359171059373e-07, 2.23284175860622529966e-08, -3.40593858782149923252e-09,
+        5.04654734183512004012e-10, -7.25703261708699165492e-11, 1.02015947887744908988e-11,
+        -1.51201806148991717186e-12, 2.02065147504418727910e-13 };
+    static constexpr double kErfcMid[] = { 1.06666666666666666667e+01, -1.66666666666666666667e+00 };
+    static constexpr double kErfcW1[] = {
+        5.27749069320452776958e-01, -1.83931461632903650530e-02, 1.61228401714450069914e-03,
+        -2.04012847982121653491e-04, 3.20009569888801972410e-05, -5.80647341567505365810e-06,
+        1.17268167080605131255e-06, -2.57341737407849501446e-07, 6.03738913416140500595e-08,
+        -1.49686729624653233981e-08, 3.88835277060595061723e-09, -1.05038940822239872053e-09,
+        2.94037638582891640355e-10, -8.63592637591078292496e-11, 2.56832036729169669899e-11,
+        -6.47515582475977207300e-12, 1.98057512712089737733e-12, -1.29467541655074026526e-12,
+        4.26029925241640595840e-13 };
+    static constexpr double kErfcTail[] = { 3.27180925666199158359e+01, -1.04488078541374473974e+00 };
+    static constexpr double kErfcW2[] = {
+        5.55581126184417047541e-01, -7.88231103448427490111e-03, 3.17742570861191541554e-04,
+        -2.02966800128680053706e-05, 1.73151372408515070272e-06, -1.81697066561325592156e-07,
+        2.23509181632817889634e-08, -3.12347651186669604179e-09, 4.85113418234780374032e-10,
+        -8.24359957156165530121e-11, 1.51270092007361536051e-11, -2.91482693518214136589e-12,
+        6.04866206326578561914e-13, -1.68879936628354582857e-13, 3.96975618306534715461e-14 };
+};
+
+template <typename T>
+inline T from_bits(typename MathConst<T>::Bits b) {
+    T v;
+    std::memcpy(&v, &b, sizeof v);
+    return v;
+}
+
+// ------------------------------
+// Scalar reference, also the FT_SIMD=scalar path. Integer T computes in
+// double and truncates, as the lazy ops always did
+// ------------------------------
+template <typename T>
+using math_t = typename std::conditional<std::is_floating_point<T>::value, T, double>::type;
+
+template <typename T>
+struct ScalarMath {
+    using F = math_t<T>;
+    static T exp(T x) { return static_cast<T>(std::exp(F(x))); }
+    static T log(T x) { return static_cast<T>(std::log(F(x))); }
+    static T sin(T x) { return static_cast<T>(std::sin(F(x))); }
+    static T cos(T x) { return static_cast<T>(std::cos(F(x))); }
+    static T tanh(T x) { return static_cast<T>(std::tanh(F(x))); }
+    static T sigmoid(T x) { return static_cast<T>(F(1) / (F(1) + std::exp(-F(x)))); }
+    // erfc keeps the relative accuracy of the negative side; its argument
+    // is rounded in long double, erfc magnifies that error by 2 v^2
+    static T gelu(T x) {
+        long double v = -static_cast<long double>(x) * 0.707106781186547524401L;
+        return static_cast<T>(0.5L * static_cast<long double>(x) * std::erfc(v));
+    }
+    static T pow(T x, T p) { return static_cast<T>(std::pow(F(x), F(p))); }
+};
+
+} // namespace simd
+
+// Vector math over one traits struct. Besides the FT_SIMD_KERNELS set the
+// traits provide: a mask type M with lt/le/eq/nan_mask/mor/any/select,
+// bitwise band/bor/bxor/bandnot, vround (to nearest), exponent (biased
+// exponent field of a positive x as T), pow2n (2^n for integral n in the
+// normal range) and has_fma (fma is fused, so two_prod is exact).
+#define FT_SIMD_MATH(ATTR)                                                      \
+    using Mc = MathConst<T>;                                                    \
+    template <size_t N>                                                         \
+    ATTR static V poly(V x, const T (&c)[N]) {                                  \
+        V r = set1(c[N - 1]);                                                   \
+        for (size_t i = N - 1; i-- > 0;) r = fma(r, x, set1(c[i]));             \
+        return r;                                                               \
+    }                                                                           \
+    ATTR static V signbit() { return set1(T(-0.0)); }                           \
+    ATTR static V vabs(V x) { return bandnot(signbit(), x); }                   \
+    /* a * b = p + lo exactly */                                                \
+    ATTR static V two_prod(V a, V b, V& lo) {                                   \
+        V p = apply<OpKind::Mul>(a, b);                                         \
+        if constexpr (has_fma) {                                                \
+            lo = fma(a, b, bxor(p, signbit()));                                 \
+        } else {                                                                \
+            const V k = set1(Mc::kSplit);                                       \
+            V ta = apply<OpKind::Mul>(a, k), tb = apply<OpKind::Mul>(b, k);     \
+            V ah = apply<OpKind::Sub>(ta, apply<OpKind::Sub>(ta, a));           \
+            V bh = apply<OpKind::Sub>(tb, apply<OpKind::Sub>(tb, b));           \
+            V al = apply<OpKind::Sub>(a, ah), bl = apply<OpKind::Sub>(b, bh);   \
+            lo = apply<OpKind::Sub>(apply<OpKind::Mul>(ah, bh), p);             \
+            lo = fma(ah, bl, lo);                                               \
+            lo = fma(al, bh, lo);                                               \
+            lo = fma(al, bl, lo);                                               \
+        }                                                                       \
+        return p;                                                               \
+    }                                                                           \
+    /* e^(x + lo), lo a small correction; 2^n applied in two steps so */        \
+    /* results near overflow and in the subnormal range are exact */            \
+    ATTR static V exp_dd(V x, V lo) {                                           \
+        V xc = apply<OpKind::Min>(apply<OpKind::Max>(x, set1(Mc::kExpMin)),     \
+                                  set1(Mc::kExpMax));                           \
+        V n = vround(apply<OpKind::Mul>(xc, set1(Mc::kLog2e)));                 \
+        V r = fma(n, set1(-Mc::kLn2Hi), xc);                                    \
+        r = apply<OpKind::Add>(fma(n, set1(-Mc::kLn2Lo), r), lo);               \
+        V p = apply<OpKind::Add>(fma(apply<OpKind::Mul>(r, r), poly(r, Mc::kExp), r), \
+                                 set1(T(1)));                                   \
+        V h = vround(apply<OpKind::Mul>(n, set1(T(0.5))));                      \
+        p = apply<OpKind::Mul>(p, pow2n(h));                                    \
+        return apply<OpKind::Mul>(p, pow2n(apply<OpKind::Sub>(n, h)));          \
+    }                                                                           \
+    ATTR static V vexp(V x) {                                                   \
+        return select(nan_mask(x), x, exp_dd(x, set1(T())));                    \
+    }                                                                           \
+    /* x = 2^e m, m in [sqrt 1/2, sqrt 2); f = m - 1; x normal, positive */     \
+    ATTR static V log_split(V x, V& f) {                                        \
+        const V one = set1(T(1));                                               \
+        V e = apply<OpKind::Sub>(exponent(x), set1(Mc::kBias));                 \
+        V m = bor(band(x, set1(from_bits<T>(Mc::kMantMask))), set1(from_bits<T>(Mc::kOne))); \
+        auto big = lt(set1(Mc::kSqrt2), m);                                     \
+        f = apply<OpKind::Sub>(select(big, apply<OpKind::Mul>(m, set1(T(0.5))), m), one); \
+        return select(big, apply<OpKind::Add>(e, one), e);                      \
+    }                                                                           \
+    ATTR static V vlog(V x) {                                                   \
+        const V zero = set1(T());                                               \
+        auto sub = lt(x, set1(Mc::kMinNormal));                                 \
+        V f, e = log_split(select(sub, apply<OpKind::Mul>(x, set1(Mc::kSubnormalScale)), x), f); \
+        e = select(sub, apply<OpKind::Sub>(e, set1(Mc::kSubnormalExp)), e);     \
+        V s = apply<OpKind::Div>(f, apply<OpKind::Add>(f, set1(T(2))));         \
+        V z = apply<OpKind::Mul>(s, s);                                         \
+        V R = apply<OpKind::Mul>(apply<OpKind::Add>(z, z), poly(z, Mc::kLog));  \
+        V hfsq = apply<OpKind::Mul>(apply<OpKind::Mul>(f, f), set1(T(0.5)));    \
+        V t = fma(e, set1(Mc::kLn2Lo), apply<OpKind::Mul>(s, apply<OpKind::Add>(hfsq, R))); \
+        V r = fma(e, set1(Mc::kLn2Hi), apply<OpKind::Sub>(f, apply<OpKind::Sub>(hfsq, t))); \
+        r = select(lt(x, zero), set1(std::numeric_limits<T>::quiet_NaN()), r);  \
+        r = select(eq(x, zero), set1(-std::numeric_limits<T>::infinity()), r);  \
+        r = select(eq(x, set1(std::numeric_limits<T>::infinity())), x, r);      \
+        return select(nan_mask(x), x, r);                                       \
+    }                                                                           \
+    /* |x| <= kTrigMax; the caller patches wider lanes */                       \
+    template <bool Cos>                                                         \
+    ATTR static V trig(V x) {                                                   \
+        const V one = set1(T(1)), three = set1(T(3));                           \
+        V k = vround(apply<OpKind::Mul>(x, set1(Mc::kTwoOverPi)));              \
+        V r = fma(k, set1(-Mc::kPio2[0]), x);                                   \
+        r = fma(k, set1(-Mc::kPio2[1]), r);                                     \
+        r = fma(k, set1(-Mc::kPio2[2]), r);                                     \
+        if constexpr (Mc::kPio2[3] != T()) r = fma(k, set1(-Mc::kPio2[3]), r);  \
+        V z = apply<OpKind::Mul>(r, r);                                         \
+        V s = fma(apply<OpKind::Mul>(r, z), poly(z, Mc::kSin), r);              \
+        V hz = apply<OpKind::Mul>(z, set1(T(0.5)));                             \
+        V w = apply<OpKind::Sub>(one, hz);                                      \
+        V c = apply<OpKind::Add>(w, fma(apply<OpKind::Mul>(z, z), poly(z, Mc::kCos), \
+                                        apply<OpKind::Sub>(apply<OpKind::Sub>(one, w), hz))); \
+        /* quadrant k mod 4, exact in floating point */                         \
+        V q = fma(vround(fma(k, set1(T(0.25)), set1(T(-0.375)))), set1(T(-4)), k); \
+        if constexpr (Cos) q = select(eq(q, three), set1(T()), apply<OpKind::Add>(q, one)); \
+        V y = select(mor(eq(q, one), eq(q, three)), c, s);                      \
+        y = select(le(set1(T(2)), q), bxor(y, signbit()), y);                   \
+        /* the reduction turns -0 into +0 */                                    \
+        if constexpr (!Cos) y = select(eq(x, set1(T())), x, y);                 \
+        return y;                                                               \
+    }                                                                           \
+    ATTR static V vsin(V x) { return trig<false>(x); }                          \
+    ATTR static V vcos(V x) { return trig<true>(x); }                           \
+    ATTR static V vtanh(V x) {                                                  \
+        const V one = set1(T(1));                                               \
+        V a = vabs(x), z = apply<OpKind::Mul>(x, x);                            \
+        V ys = fma(apply<OpKind::Mul>(x, z), poly(z, Mc::kTanh), x);            \
+        if (!any(le(set1(Mc::kTanhSmall), a))) return ys;                       \
+        V e = vexp(apply<OpKind::Add>(a, a));                                   \
+        V yl = apply<OpKind::Sub>(one, apply<OpKind::Div>(set1(T(2)), apply<OpKind::Add>(e, one))); \
+        yl = bor(yl, band(x, signbit()));                                       \
+        return select(lt(a, set1(Mc::kTanhSmall)), ys, yl);                     \
+    }                                                                           \
+    ATTR static V vsigmoid(V x) {                                               \
+        const V one = set1(T(1));                                               \
+        return apply<OpKind::Div>(one, apply<OpKind::Add>(one, vexp(bxor(x, signbit())))); \
+    }                                                                           \
+    /* x Phi(x). Phi(-|x|) = erfc(v) / 2, v = |x| / sqrt 2, with v^2 = x^2 / 2 */ \
+    /* carried exactly into e^-v^2, so the far tail keeps its relative error */ \
+    ATTR static V vgelu(V x) {                                                  \
+        const V zero = set1(T()), one = set1(T(1)), half = set1(T(0.5));        \
+        V a = apply<OpKind::Min>(vabs(x), set1(Mc::kGeluMax));                  \
+        V v = apply<OpKind::Mul>(a, set1(Mc::kSqrtHalf));                       \
+        V hs = apply<OpKind::Mul>(apply<OpKind::Mul>(half, v),                  \
+                                  poly(apply<OpKind::Mul>(v, v), Mc::kErf));    \
+        auto neg = lt(x, zero);                                                 \
+        V phi = select(neg, apply<OpKind::Sub>(half, hs), apply<OpKind::Add>(half, hs)); \
+        V y = apply<OpKind::Mul>(x, phi);                                       \
+        if (any(le(one, v))) {                                                  \
+            V zl, zh = two_prod(apply<OpKind::Mul>(a, half), a, zl);            \
+            V ex = apply<OpKind::Mul>(vexp(bxor(zh, signbit())), apply<OpKind::Sub>(one, zl)); \
+            V R = poly(fma(v, set1(T(2)), set1(T(-3))), Mc::kErfcV);             \
+            if (any(le(set1(T(2)), v))) {                                       \
+                V w = apply<OpKind::Div>(one, zh);                              \
+                V inv = apply<OpKind::Mul>(v, w);                               \
+                V R1 = poly(fma(w, set1(Mc::kErfcMid[0]), set1(Mc::kErfcMid[1])), Mc::kErfcW1); \
+                if (any(le(set1(T(4)), v))) {                                   \
+                    V R2 = poly(fma(w, set1(Mc::kErfcTail[0]), set1(Mc::kErfcTail[1])), Mc::kErfcW2); \
+                    R1 = select(lt(v, set1(T(4))), R1, R2);                     \
+                }                                                               \
+                R = select(lt(v, set1(T(2))), R, apply<OpKind::Mul>(R1, inv));  \
+            }                                                                   \
+            /* x erfc(v) / 2, e^-v^2 last so only a tiny result underflows */   \
+            V t = apply<OpKind::Mul>(ex, apply<OpKind::Mul>(R, apply<OpKind::Mul>(half, x))); \
+            t = select(lt(set1(Mc::kGeluMax), vabs(x)), zero, t);               \
+            y = select(lt(v, one), y, select(neg, t, apply<OpKind::Sub>(x, t)));  \
+        }                                                                       \
+        return select(nan_mask(x), x, y);                                       \
+    }                                                                           \
+    /* |x|^p for normal |x|: log in double-T, p log x split hi + lo, then */    \
+    /* exp of the pair */                                                       \
+    ATTR static V vpow_abs(V x, V p) {                                          \
+        const V two = set1(T(2));                                               \
+        V f, e = log_split(x, f);                                               \
+        V dh = apply<OpKind::Add>(f, two);                                      \
+        V dl = apply<OpKind::Sub>(f, apply<OpKind::Sub>(dh, two));              \
+        /* sh need not be correctly rounded, sl takes the exact residual */     \
+        V inv = apply<OpKind::Div>(set1(T(1)), dh);                             \
+        V sh = apply<OpKind::Mul>(f, inv);                                      \
+        V pl, ph = two_prod(sh, dh, pl);                                        \
+        V sl = apply<OpKind::Sub>(apply<OpKind::Sub>(apply<OpKind::Sub>(f, ph), pl), \
+                                  apply<OpKind::Mul>(sh, dl));                  \
+        sl = apply<OpKind::Mul>(sl, inv);                                       \
+        V z = apply<OpKind::Mul>(sh, sh);                                       \
+        V R = apply<OpKind::Mul>(apply<OpKind::Add>(z, z), poly(z, Mc::kLog));  \
+        V hi = apply<OpKind::Add>(sh, sh);                                      \
+        V lo = fma(sh, R, apply<OpKind::Add>(sl, sl));                          \
+        /* + e ln2: two-sum, e * kLn2Hi is exact */                             \
+        V a = apply<OpKind::Mul>(e, set1(Mc::kLn2Hi));                          \
+        V S = apply<OpKind::Add>(a, hi);                                        \
+        V bb = apply<OpKind::Sub>(S, a);                                        \
+        V Sl = apply<OpKind::Add>(apply<OpKind::Sub>(a, apply<OpKind::Sub>(S, bb)), \
+                                  apply<OpKind::Sub>(hi, bb));                  \
+        Sl = apply<OpKind::Add>(Sl, fma(e, set1(Mc::kLn2Lo), lo));              \
+        V Lh = apply<OpKind::Add>(S, Sl);                                       \
+        V Ll = apply<OpKind::Sub>(Sl, apply<OpKind::Sub>(Lh, S));               \
+        V yl, yh = two_prod(p, Lh, yl);                                         \
+        yl = fma(p, Ll, yl);                                                    \
+        /* far outside the exp range the low part is meaningless */             \
+        yl = select(lt(vabs(yh), set1(T(2) * Mc::kExpMax)), yl, set1(T()));     \
+        return exp_dd(yh, yl);                                                  \
+    }                                                                           \
+    /* ------------------------------ */                                        \
+    /* Array kernels; tails run through the vector path on a padded */          \
+    /* copy so results do not depend on the position in the array */           \
+    /* ------------------------------ */                                        \
+    template <V (*F)(V)>                                                        \
+    ATTR static void map(const T* a, T* o, size_t n) {                          \
+        size_t i = 0;                                                           \
+        for (; i + W <= n; i += W) store(o + i, F(load(a + i)));                \
+        if (i < n) {                                                            \
+            T buf[W];                                                           \
+            for (size_t j = 0; j < W; ++j) buf[j] = i + j < n ? a[i + j] : T(1); \
+            store(buf, F(load(buf)));                                           \
+            for (size_t j = 0; i + j < n; ++j) o[i + j] = buf[j];               \
+        }                                                                       \
+    }                                                                           \
+    ATTR static void exp(const T* a, T* o, size_t n) { map<&vexp>(a, o, n); }    \
+    ATTR static void log(const T* a, T* o, size_t n) { map<&vlog>(a, o, n); }    \
+    ATTR static void tanh(const T* a, T* o, size_t n) { map<&vtanh>(a, o, n); }  \
+    ATTR static void sigmoid(const T* a, T* o, size_t n) { map<&vsigmoid>(a, o, n); } \
+    ATTR static void gelu(const T* a, T* o, size_t n) { map<&vgelu>(a, o, n); }  \
+    /* sin / cos; lanes past kTrigMax (and inf) take libm */                    \
+    template <bool Cos>                                                         \
+    ATTR static void trig_map(const T* a, T* o, size_t n) {                     \
+        const V lim = set1(Mc::kTrigMax);                                       \
+        for (size_t i = 0; i < n; i += W) {                                     \
+            size_t m = std::min(W, n - i);                                      \
+            T xs[W], ys[W];                                                     \
+            for (size_t j = 0; m < W && j < W; ++j) xs[j] = j < m ? a[i + j] : T(); \
+            V x = m == W ? load(a + i) : load(xs);                              \
+            V y = trig<Cos>(x);                                                 \
+            bool wide = any(lt(lim, vabs(x)));                                  \
+            if (m == W && !wide) { store(o + i, y); continue; }                 \
+            store(xs, x);                                                       \
+            store(ys, y);                                                       \
+            if (wide)                                                           \
+                for (size_t j = 0; j < m; ++j)                                  \
+                    if (std::abs(xs[j]) > Mc::kTrigMax)                         \
+                        ys[j] = Cos ? std::cos(xs[j]) : std::sin(xs[j]);        \
+            for (size_t j = 0; j < m; ++j) o[i + j] = ys[j];                    \
+        }                                                                       \
+    }                                                                           \
+    ATTR static void sin(const T* a, T* o, size_t n) { trig_map<false>(a, o, n); } \
+    ATTR static void cos(const T* a, T* o, size_t n) { trig_map<true>(a, o, n); }  \
+    /* o = a^p, libm semantics; exact cases and non-finite p short-cut, */     \
+    /* zero, subnormal, inf and NaN lanes take libm */                          \
+    ATTR static void pow(const T* a, T p, T* o, size_t n) {                     \
+        if (p == T(1)) { if (o != a) std::memmove(o, a, n * sizeof(T)); return; } \
+        if (p == T(2)) { binary<OpKind::Mul>(a, a, o, n); return; }             \
+        if (p == T(0) || !std::isfinite(p)) {                                   \
+            for (size_t i = 0; i < n; ++i) o[i] = std::pow(a[i], p);            \
+            return;                                                             \
+        }                                                                       \
+        const bool integral = std::nearbyint(p) == p;                           \
+        const bool odd = integral && std::fmod(p, T(2)) != T();                 \
+        const V vp = set1(p), zero = set1(T());                                 \
+        const V tiny = set1(Mc::kMinNormal), inf = set1(std::numeric_limits<T>::infinity()); \
+        for (size_t i = 0; i < n; i += W) {                                     \
+            size_t m = std::min(W, n - i);                                      \
+            T xs[W], ys[W];                                                     \
+            for (size_t j = 0; m < W && j < W; ++j) xs[j] = j < m ? a[i + j] : T(1); \
+            V x = m == W ? load(a + i) : load(xs), ax = vabs(x);                \
+            V y = vpow_abs(ax, vp);                                             \
+            if (odd) y = bor(y, band(x, signbit()));                            \
+            if (!integral) y = select(lt(x, zero), set1(std::numeric_limits<T>::quiet_NaN()), y); \
+            bool special = any(mor(mor(lt(ax, tiny), eq(ax, inf)), nan_mask(x))); \
+            if (m == W && !special) { store(o + i, y); continue; }              \
+            store(xs, x);                                                       \
+            store(ys, y);                                                       \
+            if (special)                                                        \
+                for (size_t j = 0; j < m; ++j)                                  \
+                    if (!(std::abs(xs[j]) >= Mc::kMinNormal) || std::isinf(xs[j])) \
+                        ys[j] = std::pow(xs[j], p);                             \
+            for (size_t j = 0; j < m; ++j) o[i + j] = ys[j];                    \
+        }                                                                       \
+    }                                                                           \
+    /* ------------------------------ */                                        \
+    /* Row kernels: n >= 1 contiguous values, one statistics sweep, then */     \
+    /* one normalize sweep. The statistics are gathered block by block: */      \
+    /* each block of blk values is read twice while it sits in L1, the */       \
+    /* row once from memory */                                                  \
+    /* ------------------------------ */                                        \
+    static constexpr size_t kRowBlocks = 64;                                    \
+    /* block length: a multiple of W, >= 8 vectors, <= kRowBlocks blocks */     \
+    static size_t row_block(size_t n) {                                         \
+        size_t b = (n + kRowBlocks - 1) / kRowBlocks;                           \
+        return std::max<size_t>(8 * W, (b + W - 1) / W * W);                    \
+    }                                                                           \
+    ATTR static T hsum(V v) {                                                   \
+        T l[W];                                                                 \
+        store(l, v);                                                            \
+        T s = T();                                                              \
+        for (size_t j = 0; j < W; ++j) s += l[j];                               \
+        return s;                                                               \
+    }                                                                           \
+    ATTR static T block_max(const T* x, size_t n) {                             \
+        T mx = x[0];                                                            \
+        size_t i = 0;                                                           \
+        if (n >= W) {                                                           \
+            V m = load(x);                                                      \
+            for (i = W; i + W <= n; i += W) m = apply<OpKind::Max>(m, load(x + i)); \
+            T l[W];                                                             \
+            store(l, m);                                                        \
+            for (size_t j = 0; j < W; ++j) mx = scalar_apply<OpKind::Max>(mx, l[j]); \
+        }                                                                       \
+        for (; i < n; ++i) mx = scalar_apply<OpKind::Max>(mx, x[i]);            \
+        return mx;                                                              \
+    }                                                                           \
+    ATTR static T block_sum(const T* x, size_t n) {                             \
+        V acc = set1(T());                                                      \
+        size_t i = 0;                                                           \
+        for (; i + W <= n; i += W) acc = apply<OpKind::Add>(acc, load(x + i));  \
+        T s = hsum(acc);                                                        \
+        for (; i < n; ++i) s += x[i];                                           \
+        return s;                                                               \
+    }                                                                           \
+    /* e^(x - mx) per lane, stored to y unless y is null */                     \
+    ATTR static V exp_sum(const T* x, T* y, size_t n, T mx) {                   \
+        const V vm = set1(mx);                                                  \
+        V acc = set1(T());                                                      \
+        size_t i = 0;                                                           \
+        for (; i + W <= n; i += W) {                                            \
+            V e = vexp(apply<OpKind::Sub>(load(x + i), vm));                    \
+            if (y) store(y + i, e);                                             \
+            acc = apply<OpKind::Add>(acc, e);                                   \
+        }                                                                       \
+        if (i < n) {                                                            \
+            T buf[W];                                                           \
+            for (size_t j = 0; j < W; ++j)                                      \
+                buf[j] = i + j < n ? x[i + j] : -std::numeric_limits<T>::infinity(); \
+            V e = vexp(apply<OpKind::Sub>(load(buf), vm));                      \
+            acc = apply<OpKind::Add>(acc, e);                                   \
+            store(buf, e);                                                      \
+            if (y) for (size_t j = 0; i + j < n; ++j) y[i + j] = buf[j];        \
+        }                                                                       \
+        return acc;                                                             \
+    }                                                                           \
+    /* Online max and sum of e^(x - max): the sum is rescaled when a block */   \
+    /* raises the max. bm, if set, gets the running max each block was */       \
+    /* exponentiated against, y gets those exponentials */                      \
+    ATTR static T row_max_sum(const T* x, T* y, size_t n, T* bm, T& sum) {      \
+        const size_t blk = row_block(n);                                        \
+        T mx = std::numeric_limits<T>::lowest();                                \
+        V s = set1(T());                                                        \
+        for (size_t i = 0, b = 0; i < n; i += blk, ++b) {                       \
+            size_t len = std::min(blk, n - i);                                  \
+            T bx = block_max(x + i, len);                                       \
+            if (mx < bx) {                                                      \
+                s = apply<OpKind::Mul>(s, set1(std::exp(mx - bx)));             \
+                mx = bx;                                                        \
+            }                                                                   \
+            if (bm) bm[b] = mx;                                                 \
+            s = apply<OpKind::Add>(s, exp_sum(x + i, y ? y + i : nullptr, len, mx)); \
+        }                                                                       \
+        sum = hsum(s);                                                          \
+        return mx;                                                              \
+    }                                                                           \
+    ATTR static void softmax(const T* x, T* y, size_t n) {                      \
+        const size_t blk = row_block(n);                                        \
+        T bm[kRowBlocks], s;                                                    \
+        T mx = row_max_sum(x, y, n, bm, s);                                     \
+        for (size_t i = 0, b = 0; i < n; i += blk, ++b)                         \
+            scalar<OpKind::Mul>(y + i, std::exp(bm[b] - mx) / s, y + i, std::min(blk, n - i)); \
+    }                                                                           \
+    ATTR static void log_softmax(const T* x, T* y, size_t n) {                  \
+        T s;                                                                    \
+        T mx = row_max_sum(x, nullptr, n, nullptr, s);                          \
+        T ls = std::log(s);                                                     \
+        const V vm = set1(mx), vl = set1(ls);                                   \
+        size_t i = 0;                                                           \
+        for (; i + W <= n; i += W)                                              \
+            store(y + i, apply<OpKind::Sub>(apply<OpKind::Sub>(load(x + i), vm), vl)); \
+        for (; i < n; ++i) y[i] = (x[i] - mx) - ls;                             \
+    }                                                                           \
+    /* Mean and sum of squared deviations m2: per block, then merged into */    \
+    /* the running pair (Chan et al., Welford's update for whole blocks) */     \
+    ATTR static void mean_m2(const T* x, size_t n, T& mean, T& m2) {            \
+        const size_t blk = row_block(n);                                        \
+        T cnt = T();                                                            \
+        mean = m2 = T();                                                        \
+        for (size_t i = 0; i < n; i += blk) {                                   \
+            size_t len = std::min(blk, n - i);                                  \
+            T nb = T(len), mb = block_sum(x + i, len) / nb;                     \
+            T qb = sqdev(x + i, len, mb);                                       \
+            T nt = cnt + nb, d = mb - mean;                                     \
+            mean += d * (nb / nt);                                              \
+            m2 += qb + d * d * (cnt * nb / nt);                                 \
+            cnt = nt;                                                           \
+        }                                                                       \
+    }                                                                           \
+    /* y = (x - shift) * scale * gamma + beta, gamma and beta optional */       \
+    ATTR static void affine(const T* x, T* y, size_t n, T shift, T scale,       \
+                            const T* gamma, const T* beta) {                    \
+        const V vs = set1(shift), vk = set1(scale), zero = set1(T());           \
+        size_t i = 0;                                                           \
+        for (; i + W <= n; i += W) {                                            \
+            V t = apply<OpKind::Mul>(apply<OpKind::Sub>(load(x + i), vs), vk);  \
+            V b = beta ? load(beta + i) : zero;                                 \
+            store(y + i, gamma ? fma(t, load(gamma + i), b) : apply<OpKind::Add>(t, b)); \
+        }                                                                       \
+        for (; i < n; ++i) {                                                    \
+            T t = (x[i] - shift) * scale;                                       \
+            y[i] = (gamma ? t * gamma[i] : t) + (beta ? beta[i] : T());         \
+        }                                                                       \
+    }                                                                           \
+    ATTR static void layernorm(const T* x, T* y, size_t n, T eps,               \
+                               const T* gamma, const T* beta) {                 \
+        T mean, m2;                                                             \
+        mean_m2(x, n, mean, m2);                                                \
+        affine(x, y, n, mean, T(1) / std::sqrt(m2 / T(n) + eps), gamma, beta);  \
+    }                                                                           \
+    ATTR static void rmsnorm(const T* x, T* y, size_t n, T eps,                 \
+                             const T* gamma, const T* beta) {                   \
+        T ms = sqdev(x, n, T()) / T(n);                                         \
+        affine(x, y, n, T(), T(1) / std::sqrt(ms + eps), gamma, beta);          \
+    }